@@ -0,0 +1,159 @@
+/*
+   cache_aligned_array.h: キャッシュラインに揃えた配列。
+
+   The MIT License (MIT)
+
+   Copyright (c) 2014 Hironori Ishibashi
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+
+#ifndef CACHE_ALIGNED_ARRAY_H
+#define CACHE_ALIGNED_ARRAY_H
+
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include "common.h"
+
+namespace Sayuri {
+  // 先頭をキャッシュラインに揃えた配列のクラス。
+  // C++11のnewは大きなアラインメントを保証しないので、
+  // 1ライン分余分に確保して先頭をずらし、そこに要素を作る。
+  // 要素の型をalignas(CACHE_LINE_SIZE)にしておけば、
+  // 各要素が別々のキャッシュラインに乗る。
+  template<class T>
+  class CacheAlignedArray {
+    public:
+      /**************************/
+      /* コンストラクタと代入。 */
+      /**************************/
+      CacheAlignedArray() : memory_(nullptr), array_(nullptr), size_(0) {}
+      // [引数]
+      // size: 要素の数。
+      explicit CacheAlignedArray(std::size_t size) :
+      memory_(nullptr), array_(nullptr), size_(0) {
+        Reset(size);
+      }
+      // 要素の場所が変わるとキャッシュラインがずれるので、コピーしない。
+      CacheAlignedArray(const CacheAlignedArray<T>& array) = delete;
+      CacheAlignedArray(CacheAlignedArray<T>&& array) = delete;
+      CacheAlignedArray<T>& operator=
+      (const CacheAlignedArray<T>& array) = delete;
+      CacheAlignedArray<T>& operator=(CacheAlignedArray<T>&& array) = delete;
+      virtual ~CacheAlignedArray() {Free();}
+
+      /********************/
+      /* パブリック関数。 */
+      /********************/
+      // 配列を作り直す。要素はデフォルトコンストラクタで作る。
+      // [引数]
+      // size: 要素の数。
+      void Reset(std::size_t size) {
+        Free();
+        if (size == 0) return;
+
+        memory_ = new char[(sizeof(T) * size) + CACHE_LINE_SIZE];
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(memory_);
+        address = (address + CACHE_LINE_SIZE - 1)
+        & ~static_cast<std::uintptr_t>(CACHE_LINE_SIZE - 1);
+        array_ = reinterpret_cast<T*>(address);
+        for (; size_ < size; size_++) {
+          new (&(array_[size_])) T();
+        }
+      }
+
+      // 要素を得る。
+      // [引数]
+      // index: 要素の番号。
+      // [戻り値]
+      // 要素。
+      T& operator[](std::size_t index) {return array_[index];}
+      const T& operator[](std::size_t index) const {return array_[index];}
+
+      /**************/
+      /* アクセサ。 */
+      /**************/
+      // 要素の数。
+      std::size_t size() const {return size_;}
+
+    private:
+      /**********************/
+      /* プライベート関数。 */
+      /**********************/
+      // 要素を破棄して、メモリを解放する。
+      void Free() {
+        for (; size_ > 0; size_--) {
+          array_[size_ - 1].~T();
+        }
+        delete[] memory_;
+        memory_ = nullptr;
+        array_ = nullptr;
+      }
+
+      /****************/
+      /* メンバ変数。 */
+      /****************/
+      // 確保したメモリの先頭。
+      char* memory_;
+      // キャッシュラインに揃えた要素の配列。
+      T* array_;
+      // 要素の数。
+      std::size_t size_;
+  };
+
+  // 先頭をキャッシュラインに揃えた1つのオブジェクトを持つクラス。
+  // std::unique_ptrと同じように使う。
+  template<class T>
+  class CacheAlignedPtr {
+    public:
+      /**************************/
+      /* コンストラクタと代入。 */
+      /**************************/
+      CacheAlignedPtr() {}
+      CacheAlignedPtr(const CacheAlignedPtr<T>& ptr) = delete;
+      CacheAlignedPtr(CacheAlignedPtr<T>&& ptr) = delete;
+      CacheAlignedPtr<T>& operator=(const CacheAlignedPtr<T>& ptr) = delete;
+      CacheAlignedPtr<T>& operator=(CacheAlignedPtr<T>&& ptr) = delete;
+      virtual ~CacheAlignedPtr() {}
+
+      /********************/
+      /* パブリック関数。 */
+      /********************/
+      // オブジェクトを作り直す。デフォルトコンストラクタで作る。
+      void Reset() {array_.Reset(1);}
+
+      // オブジェクトを得る。
+      T& operator*() {return array_[0];}
+      const T& operator*() const {return array_[0];}
+      T* operator->() {return &(array_[0]);}
+      const T* operator->() const {return &(array_[0]);}
+      // オブジェクトを持っているかどうか。
+      explicit operator bool() const {return array_.size() > 0;}
+
+    private:
+      /****************/
+      /* メンバ変数。 */
+      /****************/
+      // 要素1つの配列。
+      CacheAlignedArray<T> array_;
+  };
+}  // namespace Sayuri
+
+#endif
@@ -47,12 +47,15 @@ namespace Sayuri {
   constexpr std::size_t UCI_MAX_TABLE_SIZE = 1024ULL * 1024ULL * 1024ULL;
 #else  // 64ビットCPU用定数。
   constexpr std::size_t UCI_MAX_TABLE_SIZE =
-  8ULL * 1024ULL * 1024ULL * 1024ULL;
+  1024ULL * 1024ULL * 1024ULL * 1024ULL;
 #endif
   constexpr bool UCI_DEFAULT_PONDER = true;
   constexpr int UCI_DEFAULT_THREADS = 1;
   constexpr int UCI_MAX_THREADS = 64;
+  constexpr bool UCI_DEFAULT_LAZY_SMP = false;
   constexpr bool UCI_DEFAULT_ANALYSE_MODE = false;
+  constexpr bool UCI_DEFAULT_USE_HUGE_PAGES = true;
+  constexpr const char* UCI_DEFAULT_HASH_FILE = "sayuri.hash";
 
   /**********/
   /* 基本。 */
@@ -321,12 +324,15 @@ namespace Sayuri {
   }
 
   // 手の比較。
-  inline bool EqualMove(Move& move_1, Move& move_2) {
+  inline bool EqualMove(Move move_1, Move move_2) {
     return (move_1 & BASE_MASK) == (move_2 & BASE_MASK);
   }
 
   // ハッシュの型。
   using Hash = std::uint64_t;
+  // ハッシュの配列を生成する乱数のシード。
+  // 変えると保存したトランスポジションテーブルなどが使えなくなる。
+  constexpr Hash ZOBRIST_SEED = 0x5341595552493134ULL;
 
   // 評価値の定義。
   // 勝ち。
@@ -346,6 +352,39 @@ namespace Sayuri {
     BETA  // ベータ値。
   };
 
+  // TTEntryに評価値の種類を記録するビット数とマスク。
+  constexpr int TT_BOUND_BITS = 2;
+  constexpr int TT_BOUND_MASK = (1 << TT_BOUND_BITS) - 1;
+  // TTEntryにテーブルの年齢を記録するビット数とマスク。
+  constexpr int TT_AGE_BITS = 8 - TT_BOUND_BITS;
+  constexpr int TT_AGE_MASK = (1 << TT_AGE_BITS) - 1;
+  // トランスポジションテーブルのメモリの種類。
+  enum class TTMemoryType {
+    NORMAL,  // 通常のページ。
+    HUGE_PAGES,  // ヒュージページ。(MAP_HUGETLB)
+    TRANSPARENT_HUGE_PAGES,  // Transparent Huge Pages。(MADV_HUGEPAGE)
+    MAPPED_FILE  // メモリマップされたファイル。
+  };
+  // ヒュージページのバイト数。
+  constexpr std::size_t TT_HUGE_PAGE_SIZE = 2ULL * 1024ULL * 1024ULL;
+  // テーブルを保存するファイルの識別子。8バイト。
+  constexpr const char* TT_FILE_MAGIC = "SAYURITT";
+  // テーブルを保存するファイルの形式のバージョン。
+  constexpr std::uint32_t TT_FILE_VERSION = 3;
+  // テーブルを保存するファイルのデータ部分の位置。
+  // メモリマップできるように、ページの大きさに揃える。
+  constexpr std::size_t TT_FILE_DATA_OFFSET = 4096;
+  // キャッシュラインのバイト数。クラスターの大きさ。
+  constexpr std::size_t TT_CACHE_LINE_SIZE = 64;
+  // 置換時の価値計算で、1世代の古さが深さいくつ分に相当するか。
+  constexpr int TT_AGE_WEIGHT = 4;
+  // 置換時の価値計算で、正確な評価値のエントリーに加える深さ。
+  constexpr int TT_EXACT_BONUS = 2;
+  // 使用率を計算するために調べる、テーブル先頭のクラスターの個数。
+  constexpr std::size_t TT_HASHFULL_SAMPLE_CLUSTERS = 250;
+  // エントリーに静的評価値がないことを表す値。
+  constexpr int TT_NO_EVAL = -32768;
+
   /********************/
   /* 候補手の最大値。 */
   /********************/
@@ -379,6 +418,16 @@ namespace Sayuri {
   // 最大探索ノード数。
   constexpr std::uint64_t MAX_NODES = -1ULL;
 
+  // 探索中止の条件で、時間を調べる間隔。(ShouldBeStopped()の呼び出し回数)
+  constexpr int STOP_CHECK_INTERVAL = 1024;
+
+  // Lazy SMPの投票で、評価値の差に足す基本の票。
+  constexpr int LAZY_SMP_VOTE_BASE = 14;
+
+  // キャッシュラインのバイト数。
+  // スレッド間でキャッシュラインを共有しないように詰め物をする時に使う。
+  constexpr std::size_t CACHE_LINE_SIZE = 64;
+
   // 探索するノードの種類。
   enum class NodeType {
     PV,  // PVノード。
@@ -399,6 +448,9 @@ namespace Sayuri {
   namespace Chrono = std::chrono;
   using SysClock = Chrono::system_clock;
   using TimePoint = SysClock::time_point;
+  // 探索時間の計測用。時刻合わせの影響を受けない。
+  using SteadyClock = Chrono::steady_clock;
+  using SteadyTimePoint = SteadyClock::time_point;
 }  // namespace Sayuri
 
 #endif
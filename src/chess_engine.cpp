@@ -47,13 +47,26 @@
 #include "params.h"
 
 namespace Sayuri {
+  /****************/
+  /* static変数。 */
+  /****************/
+  Hash ChessEngine::piece_hash_value_table_
+  [NUM_SIDES][NUM_PIECE_TYPES][NUM_SQUARES];
+  Hash ChessEngine::to_move_hash_value_table_[NUM_SIDES];
+  Hash ChessEngine::castling_hash_value_table_[4];
+  Hash ChessEngine::en_passant_hash_value_table_[NUM_SQUARES];
+
   /**************************/
   /* コンストラクタと代入。 */
   /***************************/
   // コンストラクタ。
   ChessEngine::ChessEngine(const SearchParams& search_params,
   const EvalParams& eval_params) :
-  evaluator_(*this) {
+  evaluator_(*this),
+  thread_id_(0),
+  is_lazy_smp_helper_(false),
+  stop_check_countdown_(STOP_CHECK_INTERVAL),
+  active_job_ptr_(nullptr) {
     SetNewGame();
 
     // 探索関数用パラメータ。
@@ -72,10 +85,22 @@ namespace Sayuri {
     for (std::uint32_t i = 0; i < (MAX_PLYS + 1); i++) {
       job_table_[i].client_ptr_ = this;
     }
+
+    // 分岐点の局面。
+    record_table_.reset(new PositionRecord[MAX_PLYS + 1]);
+
+    // 手の並べ替え用テーブル。
+    ordering_st_ptr_.Reset();
+    ordering_st_ptr_->Clear();
   }
 
   // プライベートコンストラクタ。
-  ChessEngine::ChessEngine() : evaluator_(*this) {
+  ChessEngine::ChessEngine() :
+  evaluator_(*this),
+  thread_id_(0),
+  is_lazy_smp_helper_(false),
+  stop_check_countdown_(STOP_CHECK_INTERVAL),
+  active_job_ptr_(nullptr) {
     SetNewGame();
 
     // ムーブメーカー。
@@ -89,10 +114,22 @@ namespace Sayuri {
     for (std::uint32_t i = 0; i < (MAX_PLYS + 1); i++) {
       job_table_[i].client_ptr_ = this;
     }
+
+    // 分岐点の局面。
+    record_table_.reset(new PositionRecord[MAX_PLYS + 1]);
+
+    // 手の並べ替え用テーブル。
+    ordering_st_ptr_.Reset();
+    ordering_st_ptr_->Clear();
   }
 
   // コピーコンストラクタ。
-  ChessEngine::ChessEngine(const ChessEngine& engine) : evaluator_(*this) {
+  ChessEngine::ChessEngine(const ChessEngine& engine) :
+  evaluator_(*this),
+  thread_id_(0),
+  is_lazy_smp_helper_(false),
+  stop_check_countdown_(STOP_CHECK_INTERVAL),
+  active_job_ptr_(nullptr) {
     // 基本メンバをコピー。
     ScanBasicMember(engine);
 
@@ -110,10 +147,22 @@ namespace Sayuri {
     for (std::uint32_t i = 0; i < (MAX_PLYS + 1); i++) {
       job_table_[i].client_ptr_ = this;
     }
+
+    // 分岐点の局面。
+    record_table_.reset(new PositionRecord[MAX_PLYS + 1]);
+
+    // 手の並べ替え用テーブルのコピー。
+    ordering_st_ptr_.Reset();
+    *ordering_st_ptr_ = *(engine.ordering_st_ptr_);
   }
 
   // ムーブコンストラクタ。
-  ChessEngine::ChessEngine(ChessEngine&& engine) : evaluator_(*this) {
+  ChessEngine::ChessEngine(ChessEngine&& engine) :
+  evaluator_(*this),
+  thread_id_(0),
+  is_lazy_smp_helper_(false),
+  stop_check_countdown_(STOP_CHECK_INTERVAL),
+  active_job_ptr_(nullptr) {
     // 基本メンバをコピー。
     ScanBasicMember(engine);
 
@@ -131,6 +180,13 @@ namespace Sayuri {
     for (std::uint32_t i = 0; i < (MAX_PLYS + 1); i++) {
       job_table_[i].client_ptr_ = this;
     }
+
+    // 分岐点の局面。
+    record_table_.reset(new PositionRecord[MAX_PLYS + 1]);
+
+    // 手の並べ替え用テーブルのコピー。
+    ordering_st_ptr_.Reset();
+    *ordering_st_ptr_ = *(engine.ordering_st_ptr_);
   }
 
   // コピー代入。
@@ -141,6 +197,9 @@ namespace Sayuri {
     // 共有メンバをコピー。
     shared_st_ptr_.reset(new SharedStruct(*(engine.shared_st_ptr_)));
 
+    // 手の並べ替え用テーブルをコピー。
+    *ordering_st_ptr_ = *(engine.ordering_st_ptr_);
+
     return *this;
   }
 
@@ -152,6 +211,9 @@ namespace Sayuri {
     // 共有メンバをムーブ。
     shared_st_ptr_ = std::move(shared_st_ptr_);
 
+    // 手の並べ替え用テーブルをコピー。
+    *ordering_st_ptr_ = *(engine.ordering_st_ptr_);
+
     return *this;
   }
   // デストラクタ。
@@ -162,6 +224,8 @@ namespace Sayuri {
   /* ChessEngineクラスの初期化。 */
   /*******************************/
   void ChessEngine::InitChessEngine() {
+    // ハッシュの配列を初期化。
+    InitHashValueTable();
   }
 
   /********************/
@@ -211,6 +275,9 @@ namespace Sayuri {
     ply_100_ = fen.ply_100();
     ply_ = fen.ply();
 
+    // ハッシュを計算。
+    ResetKeys();
+
     // 履歴を設定。
     shared_st_ptr_->ply_100_history_.clear();
     shared_st_ptr_->ply_100_history_.push_back(ply_100_);
@@ -258,6 +325,9 @@ namespace Sayuri {
     en_passant_square_ = record.en_passant_square();
     ply_100_ = record.ply_100();
     ply_ = record.ply();
+
+    // ハッシュを計算。
+    ResetKeys();
   }
 
   // 駒を初期配置にセットする。
@@ -364,6 +434,9 @@ namespace Sayuri {
       has_castled_[side] = false;
     }
 
+    // ハッシュを計算。
+    ResetKeys();
+
     if (shared_st_ptr_) {
       // 50手ルールの履歴を初期化。
       shared_st_ptr_->ply_100_history_.clear();
@@ -446,26 +519,43 @@ namespace Sayuri {
 
     // 手数のコピー。
     ply_ = engine.ply_;
+
+    // ハッシュのコピー。
+    position_key_ = engine.position_key_;
   }
 
   // 思考を始める。
-  PVLine ChessEngine::Calculate(int num_threads, TranspositionTable& table,
-  const std::vector<Move>& moves_to_search, UCIShell& shell) {
+  PVLine ChessEngine::Calculate(int num_threads, bool use_lazy_smp,
+  TranspositionTable& table, const std::vector<Move>& moves_to_search,
+  UCIShell& shell) {
     num_threads = num_threads >= 1 ? num_threads : 1;
-    thread_vec_.resize(num_threads);
-    return std::move(SearchRoot(table, moves_to_search, shell));
+
+    // スレッドの数が変わった時だけ、スレッドと子エンジンを作り直す。
+    if (num_threads != static_cast<int>(child_vec_.size())) {
+      thread_pool_.Resize(0);
+      child_vec_.clear();
+      for (int i = 0; i < num_threads; i++) {
+        child_vec_.push_back(std::unique_ptr<ChessEngine>(new ChessEngine()));
+        child_vec_.back()->thread_id_ = i + 1;
+      }
+      thread_pool_.Resize(num_threads);
+    }
+
+    return std::move(SearchRoot(use_lazy_smp, table, moves_to_search, shell));
   }
 
   // 思考を停止する。
   void ChessEngine::StopCalculation() {
+    std::unique_lock<std::mutex> lock(shared_st_ptr_->stop_mutex_);  // ロック。
     shared_st_ptr_->stop_now_ = true;
+    shared_st_ptr_->stop_cond_.notify_all();
   }
 
   // 手を指す。
   void ChessEngine::PlayMove(Move move) {
     // 合法手かどうか調べる。
     // 手を展開する。
-    shared_st_ptr_->history_max_ = 1;  // makerが0の除算をしないように。
+    ordering_st_ptr_->history_max_ = 1;  // makerが0の除算をしないように。
     MoveMaker maker(*this);
     maker.GenMoves<GenMoveType::ALL>(0, 0, 0, 0);
     // 合法手かどうか調べる。
@@ -578,12 +668,15 @@ namespace Sayuri {
 
     // 手番を反転させる。
     to_move_ = to_move_ ^ 0x3;
+    position_key_ ^= to_move_hash_value_table_[side]
+    ^ to_move_hash_value_table_[to_move_];
 
     // 動かす前のキャスリングの権利とアンパッサンを記録する。
     move_castling_rights(move, castling_rights_);
     move_en_passant_square(move, en_passant_square_);
 
     // アンパッサンを解除。
+    position_key_ ^= en_passant_hash_value_table_[en_passant_square_];
     en_passant_square_ = 0;
 
     // 手の要素を得る。
@@ -598,6 +691,7 @@ namespace Sayuri {
     }
 
     // キャスリングの権利を更新。
+    Castling prev_castling_rights = castling_rights_;
     Piece piece = piece_board_[from];
     if (side == WHITE) {
       if (piece == KING) {
@@ -620,6 +714,7 @@ namespace Sayuri {
         }
       }
     }
+    UpdateCastlingKey(prev_castling_rights ^ castling_rights_);
 
     // 手の種類によって分岐する。
     if (move_type == CASTLING) {  // キャスリングの場合。
@@ -659,6 +754,7 @@ namespace Sayuri {
         if (((side == WHITE) && ((from + 16) == to))
         || ((side == BLACK) && ((from - 16) == to))) {
           en_passant_square_ = side == WHITE ? to - 8 : to + 8;
+          position_key_ ^= en_passant_hash_value_table_[en_passant_square_];
         }
       }
     }
@@ -671,10 +767,16 @@ namespace Sayuri {
 
     // 手番を反転させる。
     to_move_ ^=  0x3;
+    position_key_ ^= to_move_hash_value_table_[enemy_side]
+    ^ to_move_hash_value_table_[to_move_];
 
     // 動かす前のキャスリングの権利とアンパッサンを復元する。
-    castling_rights_ = move_castling_rights(move);
+    Castling prev_castling_rights = move_castling_rights(move);
+    UpdateCastlingKey(prev_castling_rights ^ castling_rights_);
+    castling_rights_ = prev_castling_rights;
+    position_key_ ^= en_passant_hash_value_table_[en_passant_square_];
     en_passant_square_ = move_en_passant_square(move);
+    position_key_ ^= en_passant_hash_value_table_[en_passant_square_];
 
     // 手の情報を得る。
     Square from = move_from(move);
@@ -787,126 +889,57 @@ namespace Sayuri {
 
     // 駒の情報からハッシュを得る。
     for (Square square = 0; square < NUM_SQUARES; square++) {
-      hash ^= shared_st_ptr_->piece_hash_value_table_
+      hash ^= piece_hash_value_table_
       [side_board_[square]][piece_board_[square]][square];
     }
 
     // 手番からハッシュを得る。
-    hash ^= shared_st_ptr_->to_move_hash_value_table_[to_move_];
+    hash ^= to_move_hash_value_table_[to_move_];
 
     // キャスリングの権利からハッシュを得る。
     Castling bit = 1;
     for (int i = 0; i < 4; i++) {
       if (castling_rights_ & bit) {
-        hash ^= shared_st_ptr_->castling_hash_value_table_[i];
+        hash ^= castling_hash_value_table_[i];
       }
       bit <<= 1;
     }
 
     // アンパッサンからハッシュを得る。
-    hash ^= shared_st_ptr_->en_passant_hash_value_table_[en_passant_square_];
+    hash ^= en_passant_hash_value_table_[en_passant_square_];
 
     return hash;
   }
 
-  // 次の局面のハッシュを得る。
-  Hash ChessEngine::GetNextHash(Hash current_hash, Move move) const {
-    // 駒の情報を得る。
-    Square from = move_from(move);
-    Square to = move_to(move);
-    Piece promotion = move_promotion(move);
-
-    // 駒の位置の種類とサイドを得る。
-    Piece piece_type = piece_board_[from];
-    Side piece_side = side_board_[from];
-
-    // 取る駒の種類とサイドを得る。
-    Piece target_type = piece_board_[to];
-    Side target_side = side_board_[to];
-    Square target_square = to;
-    if ((piece_type == PAWN) && en_passant_square_
-    && (to == en_passant_square_)) {
-      // アンパッサンの時。
-      if (piece_side == WHITE) {
-        target_square = to - 8;
-      } else {
-        target_square = to + 8;
-      }
-      target_type = piece_board_[target_square];
-    }
-
-    // 移動する駒のハッシュを削除する。
-    current_hash ^=
-    shared_st_ptr_->piece_hash_value_table_[piece_side][piece_type][from];
-
-    // 取る駒のハッシュを削除する。
-    current_hash ^= shared_st_ptr_->piece_hash_value_table_
-    [target_side][target_type][target_square];
-
-    // 移動する駒の移動先のハッシュを追加する。
-    if (promotion) {
-      current_hash ^=
-      shared_st_ptr_->piece_hash_value_table_[piece_side][promotion][to];
-    } else {
-      current_hash ^=
-      shared_st_ptr_->piece_hash_value_table_[piece_side][piece_type][to];
-    }
-
-    // 現在の手番のハッシュを削除。
-    current_hash ^= shared_st_ptr_->to_move_hash_value_table_[to_move_];
+  // ハッシュの乱数表から署名を計算する。
+  Hash ChessEngine::GetHashKeySignature() const {
+    // FNV-1aの要領で、乱数表の値を順番に混ぜていく。
+    Hash signature = 0xcbf29ce484222325ULL;
+    auto mix = [&signature](Hash value) {
+      signature ^= value;
+      signature *= 0x100000001b3ULL;
+    };
 
-    // 次の手番のハッシュを追加。
-    current_hash ^= shared_st_ptr_->to_move_hash_value_table_[to_move_ ^ 0x3];
-
-    // キャスリングのハッシュをセット。
-    Castling loss_rights = 0;
-    if (piece_side == WHITE) {
-      if (piece_type == KING) {
-        loss_rights |= WHITE_CASTLING;
-      } else if (piece_type == ROOK) {
-        if (from == H1) {
-          loss_rights |= WHITE_SHORT_CASTLING;
-        } else if (from == A1) {
-          loss_rights |= WHITE_LONG_CASTLING;
-        }
-      }
-    } else {
-      if (piece_type == KING) {
-        loss_rights |= BLACK_CASTLING;
-      } else if (piece_type == ROOK) {
-        if (from == H8) {
-          loss_rights |= BLACK_SHORT_CASTLING;
-        } else if (from == A8) {
-          loss_rights |= BLACK_LONG_CASTLING;
+    for (Side side = 0; side < NUM_SIDES; side++) {
+      for (Piece piece_type = 0; piece_type < NUM_PIECE_TYPES;
+      piece_type++) {
+        for (Square square = 0; square < NUM_SQUARES; square++) {
+          mix(piece_hash_value_table_
+          [side][piece_type][square]);
         }
       }
     }
-    Castling castling_diff =
-    (castling_rights_ & ~(loss_rights)) ^ castling_rights_;
-    Castling bit = 1;
+    for (Side side = 0; side < NUM_SIDES; side++) {
+      mix(to_move_hash_value_table_[side]);
+    }
     for (int i = 0; i < 4; i++) {
-      if (castling_diff & bit) {
-        current_hash ^= shared_st_ptr_->castling_hash_value_table_[i];
-      }
-      bit <<= 1;
+      mix(castling_hash_value_table_[i]);
     }
-
-    // とりあえずアンパッサンのハッシュを削除。
-    current_hash ^=
-    shared_st_ptr_->en_passant_hash_value_table_[en_passant_square_];
-
-    // ポーンの2歩の動きの場合はアンパッサンハッシュを追加。
-    if (piece_type == PAWN) {
-      int move_diff = to - from;
-      if (move_diff == 16) {
-        current_hash ^= shared_st_ptr_->en_passant_hash_value_table_[to - 8];
-      } else if (move_diff == -16) {
-        current_hash ^= shared_st_ptr_->en_passant_hash_value_table_[to + 8];
-      }
+    for (Square square = 0; square < NUM_SQUARES; square++) {
+      mix(en_passant_hash_value_table_[square]);
     }
 
-    // 次の局面のハッシュを返す。
-    return current_hash;
+    return signature;
   }
 
   /******************************/
@@ -922,6 +955,10 @@ namespace Sayuri {
 
     // 置く位置のメンバを消す。
     if (placed_piece) {
+      // ハッシュから駒を消す。
+      position_key_ ^=
+      piece_hash_value_table_[placed_side][placed_piece][square];
+
       position_[placed_side][placed_piece] &= ~Util::SQUARE[square];
       side_pieces_[placed_side] &= ~Util::SQUARE[square];
     }
@@ -945,6 +982,9 @@ namespace Sayuri {
     // 置く位置のサイドを書き変える。
     side_board_[square] = side;
 
+    // ハッシュに駒を加える。
+    position_key_ ^= piece_hash_value_table_[side][piece_type][square];
+
     // 置く位置のビットボードをセットする。
     position_[side][piece_type] |= Util::SQUARE[square];
     side_pieces_[side] |= Util::SQUARE[square];
@@ -969,14 +1009,31 @@ namespace Sayuri {
     PutPiece(from, EMPTY, NO_SIDE);
   }
 
+  // 局面のハッシュを全て最初から計算し直す。
+  void ChessEngine::ResetKeys() {
+    position_key_ = GetCurrentHash();
+  }
+
+  // キャスリングの権利の変化をハッシュに反映する。
+  void ChessEngine::UpdateCastlingKey(Castling castling_diff) {
+    Castling bit = 1;
+    for (int i = 0; i < 4; i++) {
+      if (castling_diff & bit) {
+        position_key_ ^= castling_hash_value_table_[i];
+      }
+      bit <<= 1;
+    }
+  }
+
   /**********************/
   /* 共有メンバ構造体。 */
   /**********************/
   // コンストラクタ。
   ChessEngine::SharedStruct::SharedStruct() :
-  history_max_(1),
+  search_params_ptr_(nullptr),
+  eval_params_ptr_(nullptr),
   i_depth_(1),
-  num_searched_nodes_(0),
+  num_node_counters_(0),
   stop_now_(false),
   max_nodes_(-1ULL),
   max_depth_(MAX_PLYS),
@@ -984,33 +1041,20 @@ namespace Sayuri {
   infinite_thinking_(false),
   move_history_(0),
   ply_100_history_(0),
-  position_history_(0),
-  eval_params_ptr_(nullptr) {
-    for (Side side = 0; side < NUM_SIDES; side++) {
-      for (Square from = 0; from < NUM_SQUARES; from++) {
-        for (Square to = 0; to < NUM_SQUARES; to++) {
-          history_[side][from][to] = 0;
-        }
-      }
-    }
-    for (unsigned int i = 0; i < (MAX_PLYS + 1); i++) {
-      iid_stack_[i] = 0;
-      killer_stack_[i][0] = 0;
-      killer_stack_[i][1] = 0;
-      killer_stack_[i + 2][0] = 0;
-      killer_stack_[i + 2][1] = 0;
-    }
-    helper_queue_ptr_.reset(new HelperQueue());
-    InitHashValueTable();
+  position_history_(0) {
+    ResetNodeCounters(1);
+    helper_queue_ptr_.reset(new HelperQueue(1));
   }
 
   // コピーコンストラクタ。
-  ChessEngine::SharedStruct::SharedStruct(const SharedStruct& shared_st) {
+  ChessEngine::SharedStruct::SharedStruct(const SharedStruct& shared_st) :
+  num_node_counters_(0) {
     ScanMember(shared_st);
   }
 
   // ムーブコンストラクタ。
-  ChessEngine::SharedStruct::SharedStruct(SharedStruct&& shared_st) {
+  ChessEngine::SharedStruct::SharedStruct(SharedStruct&& shared_st) :
+  num_node_counters_(0) {
     ScanMember(shared_st);
   }
 
@@ -1030,25 +1074,20 @@ namespace Sayuri {
 
   // メンバをコピーする。
   void ChessEngine::SharedStruct::ScanMember(const SharedStruct& shared_st) {
-    for (Side side = 0; side < NUM_SIDES; side++) {
-      for (Square from = 0; from < NUM_SQUARES; from++) {
-        for (Square to = 0; to < NUM_SQUARES; to++) {
-          history_[side][from][to] = shared_st.history_[side][from][to];
-        }
-      }
-    }
-    history_max_ = shared_st.history_max_;
-    for (std::uint32_t i = 0; i < (MAX_PLYS + 1); i++) {
-      iid_stack_[i] = shared_st.iid_stack_[i];
-      killer_stack_[i][0] = shared_st.killer_stack_[i][0];
-      killer_stack_[i][0] = shared_st.killer_stack_[i][0];
-      killer_stack_[i + 2][1] = shared_st.killer_stack_[i + 2][1];
-      killer_stack_[i + 2][1] = shared_st.killer_stack_[i + 2][1];
-    }
     i_depth_ = shared_st.i_depth_;
-    num_searched_nodes_ = shared_st.num_searched_nodes_;
+    ResetNodeCounters(shared_st.num_node_counters_);
+    for (int i = 0; i < num_node_counters_; i++) {
+      node_counters_[i].num_nodes_ =
+      shared_st.node_counters_[i].num_nodes_.load();
+      node_counters_[i].num_aborted_nodes_ =
+      shared_st.node_counters_[i].num_aborted_nodes_.load();
+      node_counters_[i].num_fail_highs_ =
+      shared_st.node_counters_[i].num_fail_highs_.load();
+      node_counters_[i].num_first_fail_highs_ =
+      shared_st.node_counters_[i].num_first_fail_highs_.load();
+    }
     start_time_ = shared_st.start_time_;
-    stop_now_ = shared_st.stop_now_;
+    stop_now_ = shared_st.stop_now_.load();
     max_nodes_ = shared_st.max_nodes_;
     max_depth_ = shared_st.max_depth_;
     thinking_time_ = shared_st.thinking_time_;
@@ -1060,30 +1099,97 @@ namespace Sayuri {
     search_params_ptr_ = shared_st.search_params_ptr_;
     eval_params_ptr_ = shared_st.eval_params_ptr_;
 
-    // ハッシュ関連。
+  }
+
+  // ノード数のカウンターを作り直して、0にする。
+  void ChessEngine::SharedStruct::ResetNodeCounters(int num_counters) {
+    num_counters = num_counters >= 1 ? num_counters : 1;
+    if (num_counters != num_node_counters_) {
+      node_counters_.Reset(num_counters);
+      num_node_counters_ = num_counters;
+    }
+    for (int i = 0; i < num_node_counters_; i++) {
+      node_counters_[i].num_nodes_ = 0;
+      node_counters_[i].num_aborted_nodes_ = 0;
+      node_counters_[i].num_fail_highs_ = 0;
+      node_counters_[i].num_first_fail_highs_ = 0;
+    }
+  }
+
+  // 全スレッドの探索したノード数の合計を得る。
+  std::uint64_t ChessEngine::SharedStruct::CountSearchedNodes() const {
+    std::uint64_t num_nodes = 0;
+    for (int i = 0; i < num_node_counters_; i++) {
+      num_nodes +=
+      node_counters_[i].num_nodes_.load(std::memory_order_relaxed);
+    }
+    return num_nodes;
+  }
+
+  // 全スレッドの打ち切ったノード数の合計を得る。
+  std::uint64_t ChessEngine::SharedStruct::CountAbortedNodes() const {
+    std::uint64_t num_nodes = 0;
+    for (int i = 0; i < num_node_counters_; i++) {
+      num_nodes +=
+      node_counters_[i].num_aborted_nodes_.load(std::memory_order_relaxed);
+    }
+    return num_nodes;
+  }
+
+  // 全スレッドのベータカットの回数の合計を得る。
+  std::uint64_t ChessEngine::SharedStruct::CountFailHighs() const {
+    std::uint64_t num_fail_highs = 0;
+    for (int i = 0; i < num_node_counters_; i++) {
+      num_fail_highs +=
+      node_counters_[i].num_fail_highs_.load(std::memory_order_relaxed);
+    }
+    return num_fail_highs;
+  }
+
+  // 全スレッドの、最初の手でのベータカットの回数の合計を得る。
+  std::uint64_t ChessEngine::SharedStruct::CountFirstFailHighs() const {
+    std::uint64_t num_fail_highs = 0;
+    for (int i = 0; i < num_node_counters_; i++) {
+      num_fail_highs +=
+      node_counters_[i].num_first_fail_highs_.load(std::memory_order_relaxed);
+    }
+    return num_fail_highs;
+  }
+
+  /************************************/
+  /* 手の並べ替え用テーブルの構造体。 */
+  /************************************/
+  // 全てのテーブルを0にする。
+  void ChessEngine::OrderingStruct::Clear() {
     for (Side side = 0; side < NUM_SIDES; side++) {
-      for (Piece piece_type = 0; piece_type < NUM_PIECE_TYPES; piece_type++) {
-        for (Square square = 0; square < NUM_SQUARES; square++) {
-          piece_hash_value_table_[side][piece_type][square] =
-          shared_st.piece_hash_value_table_[side][piece_type][square];
+      for (Square from = 0; from < NUM_SQUARES; from++) {
+        for (Square to = 0; to < NUM_SQUARES; to++) {
+          history_[side][from][to] = 0;
         }
       }
     }
-    for (Side side = 0; side < NUM_SIDES; side++) {
-      to_move_hash_value_table_[side] =
-      shared_st.to_move_hash_value_table_[side];
-    }
-    for (int i = 0; i < 4; i++) {
-      castling_hash_value_table_[i] = shared_st.castling_hash_value_table_[i];
-    }
-    for (Square square = 0; square < NUM_SQUARES; square++) {
-      en_passant_hash_value_table_[square] =
-      shared_st.en_passant_hash_value_table_[square];
+    for (std::uint32_t i = 0; i < (MAX_PLYS + 1); i++) {
+      iid_stack_[i] = 0;
+      killer_stack_[i][0] = 0;
+      killer_stack_[i][1] = 0;
+      killer_stack_[i + 2][0] = 0;
+      killer_stack_[i + 2][1] = 0;
     }
+    history_max_ = 1;
   }
 
   // ハッシュの配列を初期化する。
-  void ChessEngine::SharedStruct::InitHashValueTable() {
+  void ChessEngine::InitHashValueTable() {
+    // 固定のシードからSplitMix64で乱数を生成する。
+    Hash state = ZOBRIST_SEED;
+    auto next_random = [&state]() -> Hash {
+      state += 0x9e3779b97f4a7c15ULL;
+      Hash z = state;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      return z ^ (z >> 31);
+    };
+
     // ダブリのないハッシュを生成。
     constexpr int LENGTH =
     (NUM_SIDES * NUM_PIECE_TYPES * NUM_SQUARES) + 1 + 4 + NUM_SQUARES;
@@ -1094,7 +1200,7 @@ namespace Sayuri {
       bool loop = true;
       Hash hash = 0;
       while (loop) {
-        hash = Util::GetRandomHash();
+        hash = next_random();
         loop = false;
         if (hash == 0) {
           loop = true;
@@ -33,16 +33,21 @@
 #include <array>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
 #include "common.h"
+#include "cache_aligned_array.h"
 #include "evaluator.h"
 #include "position_record.h"
 #include "helper_queue.h"
+#include "thread_pool.h"
 
 namespace Sayuri {
   class Fen;
   class TranspositionTable;
+  class TTEntry;
   class MoveMaker;
   class Evaluator;
   class PVLine;
@@ -123,13 +128,15 @@ namespace Sayuri {
       // 思考を始める。
       // [引数]
       // num_threads: スレッド数。
+      // use_lazy_smp: YBWCの代わりにLazy SMPで並列探索するかどうか。
       // table: 使用するトランスポジションテーブル。
       // moves_to_search: 探索する候補手。空なら全ての手を探索する。
       // shell: UCI出力に使用するシェル。
       // [戻り値]
       // PVライン。
-      PVLine Calculate(int num_threads, TranspositionTable& table,
-      const std::vector<Move>& moves_to_search, UCIShell& shell);
+      PVLine Calculate(int num_threads, bool use_lazy_smp,
+      TranspositionTable& table, const std::vector<Move>& moves_to_search,
+      UCIShell& shell);
 
       // 探索を終了させる。
       void StopCalculation();
@@ -202,19 +209,18 @@ namespace Sayuri {
       // 評価値。
       int SEE(Move move) const;
 
-      // 現在の局面のハッシュを計算する。
-      // (注)計算に時間がかかる。
+      // 現在の局面のハッシュを最初から計算する。
+      // (注)計算に時間がかかる。通常はposition_key()を使う。
       // [戻り値]
       // 現在の局面のハッシュ。
       Hash GetCurrentHash() const;
 
-      // 現在の局面と動かす手から次の局面のハッシュを得る。
-      // [引数]
-      // current_hash: 現在のハッシュ。
-      // move: 次の手。
+      // ハッシュの乱数表から署名を計算する。
+      // 保存したトランスポジションテーブルが
+      // 同じ乱数表で作られたものかどうかの確認に使う。
       // [戻り値]
-      // 次の局面のハッシュ。
-      Hash GetNextHash(Hash current_hash, Move move) const;
+      // ハッシュの乱数表の署名。
+      Hash GetHashKeySignature() const;
 
       /**************/
       /* アクセサ。 */
@@ -257,21 +263,25 @@ namespace Sayuri {
       int ply() const {return ply_;}
       // キャスリングしたかどうか。
       const bool (& has_castled() const)[NUM_SIDES] {return has_castled_;}
+      // 現在の局面のハッシュ。
+      Hash position_key() const {return position_key_;}
       // ヒストリー。history()[side][from][to]。
       const std::uint64_t
       (& history() const)[NUM_SIDES][NUM_SQUARES][NUM_SQUARES] {
-        return shared_st_ptr_->history_;
+        return ordering_st_ptr_->history_;
       }
       // ヒストリーの最大値。
-      std::uint64_t history_max() const {return shared_st_ptr_->history_max_;}
+      std::uint64_t history_max() const {
+        return ordering_st_ptr_->history_max_;
+      }
       // IIDでの最善手スタック。
       const Move (& iid_stack() const)[MAX_PLYS + 1] {
-        return shared_st_ptr_->iid_stack_;
+        return ordering_st_ptr_->iid_stack_;
       }
       // キラームーブスタック。
       // killer_stack_[ply][同一レベル: 0、2プライ前: 1]
       const Move (& killer_stack() const)[MAX_PLYS + 2 + 1][2] {
-        return shared_st_ptr_->killer_stack_;
+        return ordering_st_ptr_->killer_stack_;
       }
       // 探索関数用パラメータ。
       const SearchParams& search_params() const {
@@ -304,10 +314,17 @@ namespace Sayuri {
       // 評価値。
       int Quiesce(int depth, std::uint32_t level, int alpha, int beta,
       int material, TranspositionTable& table);
+      // 静的評価値を得る。
+      // エントリーに静的評価値があれば評価関数を呼ばずにそれを使う。
+      // [引数]
+      // material: 現在のマテリアル。
+      // tt_entry: この局面のエントリー。
+      // [戻り値]
+      // 静的評価値。
+      int GetStaticEval(int material, const TTEntry& tt_entry);
       // 探索する。
       // [引数]
       // <Type>: ノードの種類。
-      // pos_hash: 現在のハッシュ。
       // depth: 現在の深さ。
       // level: 現在のレベル。
       // alpha: アルファ値。
@@ -318,21 +335,54 @@ namespace Sayuri {
       // [戻り値]
       // 評価値。
       template<NodeType Type>
-      int Search(Hash pos_hash, int depth, std::uint32_t level, int alpha,
-      int beta, int material, TranspositionTable& table, PVLine& pv_line);
+      int Search(int depth, std::uint32_t level, int alpha, int beta,
+      int material, TranspositionTable& table, PVLine& pv_line);
       // 探索のルート。
+      // Lazy SMPの場合、1本目のスレッドは通常通りに探索し、
+      // 残りのスレッドはそれぞれ独自に反復深化して、最後に投票で手を決める。
       // [引数]
+      // use_lazy_smp: YBWCの代わりにLazy SMPで並列探索するかどうか。
       // table: 使用するトランスポジションテーブル。
       // moves_to_search: 探索する候補手。空なら全ての手を探索する。
       // shell: UCI出力に使用するシェル。
       // [戻り値]
       // PVライン。
-      PVLine SearchRoot(TranspositionTable& table,
+      PVLine SearchRoot(bool use_lazy_smp, TranspositionTable& table,
       const std::vector<Move>& moves_to_search, UCIShell& shell);
       // YBWC探索用スレッド。
+      // プールのスレッドから呼ばれ、そのスレッドの子エンジンで探索する。
       // [引数]
       // shell: UCI出力に使用するシェル。
-      void ThreadYBWC(UCIShell& shell);
+      // thread_id: HelperQueueでのスレッド番号。
+      void ThreadYBWC(UCIShell& shell, int thread_id);
+      // Lazy SMP探索用スレッド。
+      // プールのスレッドから呼ばれ、そのスレッドの子エンジンで探索する。
+      // [引数]
+      // index: ヘルパーの番号。1から。
+      // record: ルートの局面。
+      // table: 使用するトランスポジションテーブル。
+      // moves_to_search: 探索する候補手。空なら全ての手を探索する。
+      // pv_line: 最後に探索し終えた深さのPVラインが格納される。
+      // depth: 最後に探索し終えた深さが格納される。
+      void ThreadLazySMP(int index, const PositionRecord& record,
+      TranspositionTable& table, const std::vector<Move>& moves_to_search,
+      PVLine& pv_line, int& depth);
+      // ヘルパーを手伝いながら、ヘルパー全員の合流を待つ。(Helpful Master)
+      // 待っている間、自分の分岐点の下で公開された仕事だけを探索する。
+      // [引数]
+      // job: 自分の分岐点。
+      void HelpHelpers(Job& job);
+      // Lazy SMPのヘルパーのルート探索。独自に反復深化する。
+      // 番号によって開始する深さとルートの手の順番をずらし、
+      // 他のスレッドと違う枝を探索させる。
+      // [引数]
+      // index: ヘルパーの番号。1から。
+      // table: 使用するトランスポジションテーブル。
+      // moves_to_search: 探索する候補手。空なら全ての手を探索する。
+      // pv_line: 最後に探索し終えた深さのPVラインが格納される。
+      // depth: 最後に探索し終えた深さが格納される。
+      void SearchRootLazySMP(int index, TranspositionTable& table,
+      const std::vector<Move>& moves_to_search, PVLine& pv_line, int& depth);
       // 並列探索。
       // [引数]
       // job: 探索用仕事。
@@ -349,9 +399,53 @@ namespace Sayuri {
       // マージン。
       int GetMargin(int depth);
       // 探索を中断しなければいけないかどうか。
+      // 時間はSTOP_CHECK_INTERVAL回に1回だけ調べる。
       // [戻り値]
       // 探索を中断しなければいけないときはtrue。
       bool ShouldBeStopped();
+      // 今探索している分岐点か、その上の分岐点がベータカットされたかどうか。
+      // [戻り値]
+      // ベータカットされていて、探索を打ち切るべきならtrue。
+      bool IsAborted() const;
+      // 探索を中止するまで待つ。
+      // StopCalculation()、EnableInfiniteThinking()、思考時間の経過で起きる。
+      void WaitForStop();
+      // このスレッドの探索したノード数を足す。
+      // 他のスレッドのカウンターには触らない。
+      // [引数]
+      // delta: 足す数。
+      void AddSearchedNodes(int delta) {
+        std::atomic<std::uint64_t>& num_nodes =
+        shared_st_ptr_->node_counters_[thread_id_].num_nodes_;
+        num_nodes.store(num_nodes.load(std::memory_order_relaxed) + delta,
+        std::memory_order_relaxed);
+      }
+      // このスレッドの打ち切ったノード数を1つ足す。
+      void CountAbortedNode() {
+        std::atomic<std::uint64_t>& num_nodes =
+        shared_st_ptr_->node_counters_[thread_id_].num_aborted_nodes_;
+        num_nodes.store(num_nodes.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+      }
+      // このスレッドのベータカットの回数を1つ足す。
+      // [引数]
+      // is_first_move: 最初に探索した手でベータカットしたかどうか。
+      void CountFailHigh(bool is_first_move) {
+        NodeCounter& counter = shared_st_ptr_->node_counters_[thread_id_];
+        counter.num_fail_highs_.store
+        (counter.num_fail_highs_.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+        if (is_first_move) {
+          counter.num_first_fail_highs_.store
+          (counter.num_first_fail_highs_.load(std::memory_order_relaxed) + 1,
+          std::memory_order_relaxed);
+        }
+      }
+      // 各スレッドのヒストリーの、前回まとめた時からの増分を足し合わせて、
+      // 全スレッドに配る。
+      // Iterative Deepeningの繰り返しの間に、マスターが呼ぶ。
+      // (注)探索用スレッドが探索していない時に呼ぶこと。
+      void MergeOrderingTables();
 
       /******************************/
       /* その他のプライベート関数。 */
@@ -389,11 +483,25 @@ namespace Sayuri {
       // to: 移動先。
       void ReplacePiece(Square from, Square to);
 
+      // 局面のハッシュを全て最初から計算し直す。
+      // 駒の配置を直接書き換えた後に呼ぶ。
+      void ResetKeys();
+
+      // キャスリングの権利の変化をハッシュに反映する。
+      // [引数]
+      // castling_diff: 変化したキャスリングの権利のビット。
+      void UpdateCastlingKey(Castling castling_diff);
+
       // SEEで使う次の手を得る。
       // [引数]
       // target: 取る駒の位置。
       Move GetNextSEEMove(Square target) const;
 
+      // ハッシュの配列を初期化する。
+      // 固定のシードから生成するので、
+      // どのエンジン、どのプロセスでも同じハッシュになる。
+      static void InitHashValueTable();
+
       /****************/
       /* メンバ変数。 */
       /****************/
@@ -427,29 +535,50 @@ namespace Sayuri {
       int ply_;
       // キャスリングしたかどうか。
       bool has_castled_[NUM_SIDES];
+      // 現在の局面のハッシュ。
+      // MakeMove()、UnmakeMove()、PutPiece()で差分更新される。
+      Hash position_key_;
 
       /********************************************************/
       /* 共有メンバ。(指定した他のエンジンと共有するメンバ。) */
       /********************************************************/
+      // スレッドごとの探索したノード数のカウンター。
+      // 隣のカウンターとキャッシュラインを共有しないように、
+      // キャッシュラインに揃える。
+      struct alignas(CACHE_LINE_SIZE) NodeCounter {
+        // 探索したノード数。書き込むのは持ち主のスレッドだけ。
+        std::atomic<std::uint64_t> num_nodes_;
+        // 上の分岐点のベータカットで打ち切ったノード数。
+        std::atomic<std::uint64_t> num_aborted_nodes_;
+        // 候補手のループでベータカットした回数。
+        std::atomic<std::uint64_t> num_fail_highs_;
+        // そのうち、最初に探索した手でベータカットした回数。
+        std::atomic<std::uint64_t> num_first_fail_highs_;
+      };
+      static_assert(sizeof(NodeCounter) == CACHE_LINE_SIZE,
+      "NodeCounter must fill exactly one cache line.");
+      static_assert(alignof(NodeCounter) == CACHE_LINE_SIZE,
+      "NodeCounter must be aligned to a cache line.");
+
       // 共有メンバ構造体。
+      // 探索中に書き込みが多いテーブルは、スレッドごとにOrderingStructに持つ。
       struct SharedStruct {
-        // ヒストリー。history_[side][from][to]。
-        std::uint64_t history_[NUM_SIDES][NUM_SQUARES][NUM_SQUARES];
-        // ヒストリーの最大値。
-        std::uint64_t history_max_;
-        // IIDでの最善手スタック。
-        Move iid_stack_[MAX_PLYS + 1];
-        // キラームーブスタック。
-        // killer_stack_[ply][同一レベル: 0、2プライ前: 1]
-        Move killer_stack_[MAX_PLYS + 2 + 1][2];
+        // 探索関数用パラメータのポインタ。
+        const SearchParams* search_params_ptr_;
+        // 評価関数用パラメータのポインタ。
+        const EvalParams* eval_params_ptr_;
         // 現在のIterative Deepeningの深さ。
         std::uint32_t i_depth_;
-        // 探索したノード数。
-        std::uint64_t num_searched_nodes_;
+        // スレッドごとの探索したノード数。 node_counters_[スレッド番号]。
+        // 先頭をキャッシュラインに揃えて確保する。
+        CacheAlignedArray<NodeCounter> node_counters_;
+        // node_counters_の数。
+        int num_node_counters_;
         // 探索開始時間。
-        TimePoint start_time_;
+        SteadyTimePoint start_time_;
         // 探索ストップ条件。何が何でも探索を中断。
-        bool stop_now_;
+        // 全スレッドが読むので、アトミックにしておく。
+        std::atomic<bool> stop_now_;
         // 探索ストップ条件。最大探索ノード数。
         std::uint64_t max_nodes_;
         // 探索ストップ条件。最大探索深さ。
@@ -466,27 +595,10 @@ namespace Sayuri {
         std::vector<PositionRecord> position_history_;
         // スレッドのキュー。
         std::unique_ptr<HelperQueue> helper_queue_ptr_;
-        // 探索関数用パラメータのポインタ。
-        const SearchParams* search_params_ptr_;
-        // 評価関数用パラメータのポインタ。
-        const EvalParams* eval_params_ptr_;
-
-        /******************/
-        /* ハッシュ関連。 */
-        /******************/
-        // 駒の情報からハッシュを得るための配列。
-        // piece_hash_value_table_[サイド][駒の種類][駒の位置]
-        Hash piece_hash_value_table_[NUM_SIDES][NUM_PIECE_TYPES][NUM_SQUARES];
-        // 手番からハッシュを得るための配列。
-        Hash to_move_hash_value_table_[NUM_SIDES];
-        // キャスリングの権利からハッシュを得るための配列。
-        // 0: 白のショートキャスリング。
-        // 1: 白のロングキャスリング。
-        // 2: 黒のショートキャスリング。
-        // 3: 黒のロングキャスリング。
-        Hash castling_hash_value_table_[4];
-        // アンパッサンの位置からハッシュを得るための配列。
-        Hash en_passant_hash_value_table_[NUM_SQUARES];
+        // 探索ストップ条件が変わった時を知らせるミューテックス。
+        std::mutex stop_mutex_;
+        // 探索ストップ条件が変わった時を知らせるコンディション。
+        std::condition_variable stop_cond_;
 
         /**************************/
         /* コンストラクタと代入。 */
@@ -505,9 +617,26 @@ namespace Sayuri {
         // [引数]
         // shared_st: コピー元。
         void ScanMember(const SharedStruct& shared_st);
-
-        // ハッシュの配列を初期化する。
-        void InitHashValueTable();
+        // ノード数のカウンターを作り直して、0にする。
+        // [引数]
+        // num_counters: カウンターの数。(スレッドの数)
+        void ResetNodeCounters(int num_counters);
+        // 全スレッドの探索したノード数の合計を得る。
+        // [戻り値]
+        // 探索したノード数。
+        std::uint64_t CountSearchedNodes() const;
+        // 全スレッドの打ち切ったノード数の合計を得る。
+        // [戻り値]
+        // 打ち切ったノード数。
+        std::uint64_t CountAbortedNodes() const;
+        // 全スレッドのベータカットの回数の合計を得る。
+        // [戻り値]
+        // ベータカットの回数。
+        std::uint64_t CountFailHighs() const;
+        // 全スレッドの、最初の手でのベータカットの回数の合計を得る。
+        // [戻り値]
+        // 最初の手でのベータカットの回数。
+        std::uint64_t CountFirstFailHighs() const;
 
       };
       std::shared_ptr<SharedStruct> shared_st_ptr_;
@@ -515,6 +644,30 @@ namespace Sayuri {
       /************************************************************/
       /* 固有メンバ。(他のエンジンとコピーも共有もしないメンバ。) */
       /************************************************************/
+      // 手の並べ替えに使うテーブルの構造体。
+      // 探索中に書き込みが多いので、スレッドごとに持つ。
+      // 他のスレッドのテーブルとキャッシュラインを共有しないように、
+      // キャッシュラインに揃える。
+      struct alignas(CACHE_LINE_SIZE) OrderingStruct {
+        // ヒストリー。history_[side][from][to]。
+        std::uint64_t history_[NUM_SIDES][NUM_SQUARES][NUM_SQUARES];
+        // ヒストリーの最大値。
+        std::uint64_t history_max_;
+        // IIDでの最善手スタック。
+        Move iid_stack_[MAX_PLYS + 1];
+        // キラームーブスタック。
+        // killer_stack_[ply][同一レベル: 0、2プライ前: 1]
+        Move killer_stack_[MAX_PLYS + 2 + 1][2];
+
+        // 全てのテーブルを0にする。
+        void Clear();
+      };
+      // 手の並べ替えに使うテーブル。
+      // 先頭をキャッシュラインに揃えて、エンジンごとに別々に確保する。
+      CacheAlignedPtr<OrderingStruct> ordering_st_ptr_;
+      // MergeOrderingTables()で前回まとめたテーブル。
+      // 探索用スレッドの増分を求めるのに使う。マスターだけが使う。
+      CacheAlignedPtr<OrderingStruct> merged_st_ptr_;
       // 今ヌルムーブのサーチ中かどうか。
       bool is_null_searching_;
       // 探索したレベル。
@@ -523,12 +676,46 @@ namespace Sayuri {
       std::unique_ptr<MoveMaker[]> maker_table_;
       // Evaluator。
       Evaluator evaluator_;
+      // HelperQueueに分岐点を公開するときのスレッド番号。
+      int thread_id_;
+      // Lazy SMPのヘルパーとして探索しているかどうか。
+      // trueなら分岐点を公開しない。
+      bool is_lazy_smp_helper_;
+      // 探索中止の条件の時間を次に調べるまでの、ShouldBeStopped()の回数。
+      // このエンジンを動かしているスレッドだけが読み書きする。
+      int stop_check_countdown_;
+      // 今探索している一番下の分岐点。無ければnullptr。
+      // 新しく公開する仕事の親になる。
+      Job* active_job_ptr_;
       // マルチスレッド用仕事のテーブル。 job_table_[level]。
       std::unique_ptr<Job[]> job_table_;
-      // ミューテックス。
-      std::mutex mutex_;
-      // スレッドのベクトル。
-      std::vector<std::thread> thread_vec_;
+      // 分岐点の局面のテーブル。 record_table_[level]。
+      // 分岐した時だけ記録する。
+      std::unique_ptr<PositionRecord[]> record_table_;
+      // 探索用スレッドの子エンジン。 child_vec_[スレッドの番号 - 1]。
+      // スレッドの数が変わるまで使い回す。
+      std::vector<std::unique_ptr<ChessEngine>> child_vec_;
+      // 探索用スレッドのプール。
+      // 子エンジンより先に破棄されるように、後に宣言する。
+      ThreadPool thread_pool_;
+
+      /****************/
+      /* static変数。 */
+      /****************/
+      // 駒の情報からハッシュを得るための配列。
+      // piece_hash_value_table_[サイド][駒の種類][駒の位置]
+      static Hash piece_hash_value_table_
+      [NUM_SIDES][NUM_PIECE_TYPES][NUM_SQUARES];
+      // 手番からハッシュを得るための配列。
+      static Hash to_move_hash_value_table_[NUM_SIDES];
+      // キャスリングの権利からハッシュを得るための配列。
+      // 0: 白のショートキャスリング。
+      // 1: 白のロングキャスリング。
+      // 2: 黒のショートキャスリング。
+      // 3: 黒のロングキャスリング。
+      static Hash castling_hash_value_table_[4];
+      // アンパッサンの位置からハッシュを得るための配列。
+      static Hash en_passant_hash_value_table_[NUM_SQUARES];
   };
 }  // namespace Sayuri
 
@@ -53,8 +53,14 @@ namespace Sayuri {
     // 探索中止の時。
     if (ShouldBeStopped()) return alpha;
 
+    // 上の分岐点がベータカットされて、探索が無駄になった時。
+    if (IsAborted()) {
+      CountAbortedNode();
+      return alpha;
+    }
+
     // ノード数を加算。
-    shared_st_ptr_->num_searched_nodes_++;
+    AddSearchedNodes(1);
 
     // 最大探索数。
     if (level > searched_level_) {
@@ -65,11 +71,56 @@ namespace Sayuri {
     Side side = to_move_;
     Side enemy_side = side ^ 0x3;
 
+    // トランスポジションテーブルを調べる。
+    // クイース探索のエントリーは深さ0で登録されているので、
+    // 深さ0以上のエントリーなら全て使える。
+    Hash pos_hash = position_key_;
+    Move tt_move = 0;
+    TTEntry tt_entry;
+    bool enable_ttable =
+    shared_st_ptr_->search_params_ptr_->enable_ttable();
+    if (enable_ttable) {
+      tt_entry = table.GetEntry(pos_hash, 0);
+      if (tt_entry) {
+        int score = tt_entry.score();
+        ScoreType tt_score_type = tt_entry.score_type();
+        if (tt_score_type != ScoreType::ALPHA) {
+          tt_move = tt_entry.best_move();
+        }
+
+        // 局面の繰り返し対策などのため、
+        // 自分の初手と相手の初手の場合(level < 2の場合)は値を使わない。
+        if (level >= 2) {
+          if (tt_score_type == ScoreType::EXACT) {
+            // エントリーが正確な値。
+            if (score >= beta) return beta;
+            if (score <= alpha) return alpha;
+            return score;
+          } else if (tt_score_type == ScoreType::ALPHA) {
+            // エントリーがアルファ値。
+            if (score <= alpha) return alpha;
+          } else {
+            // エントリーがベータ値。
+            if (score >= beta) return beta;
+          }
+        }
+      }
+    }
+
+    // テーブルに登録する評価値の種類を決めるため、元のアルファ値を保存。
+    int original_alpha = alpha;
+
     // stand_pad。
-    int stand_pad = evaluator_.Evaluate(material);
+    int stand_pad = GetStaticEval(material, tt_entry);
 
     // アルファ値、ベータ値を調べる。
+    // stand_padでのカットも、静的評価値を残すために登録する。
     if (stand_pad >= beta) {
+      if (enable_ttable && !is_null_searching_ && !ShouldBeStopped()
+      && !IsAborted()) {
+        table.Add(pos_hash, 0, stand_pad, ScoreType::BETA, 0, -1,
+        stand_pad);
+      }
       return beta;
     }
     if (stand_pad > alpha) {
@@ -85,10 +136,11 @@ namespace Sayuri {
     // 候補手を作る。
     // 駒を取る手だけ。
     MoveMaker& maker = maker_table_[level];
+    // テーブルの最善手を最初に探索する。
     if (IsAttacked(king_[side], enemy_side)) {
-      maker.GenMoves<GenMoveType::ALL>(0, 0, 0, 0);
+      maker.GenMoves<GenMoveType::ALL>(tt_move, 0, 0, 0);
     } else {
-      maker.GenMoves<GenMoveType::CAPTURE>(0, 0, 0, 0);
+      maker.GenMoves<GenMoveType::CAPTURE>(tt_move, 0, 0, 0);
     }
 
     // 探索する。
@@ -98,11 +150,20 @@ namespace Sayuri {
     bool enable_futility_pruning =
     shared_st_ptr_->search_params_ptr_->enable_futility_pruning();
 
+    // 最善手と評価値の種類。
+    Move best_move = 0;
+    ScoreType score_type = ScoreType::ALPHA;
+
     for (Move move = maker.PickMove(); move; move = maker.PickMove()) {
       // 次の自分のマテリアル。
       int next_my_material = GetNextMyMaterial(material, move);
 
       MakeMove(move);
+      // 子ノードのエントリーを先読みする。
+      if (enable_ttable
+      && shared_st_ptr_->search_params_ptr_->enable_prefetch()) {
+        table.Prefetch(position_key_);
+      }
 
       // 合法手かどうか調べる。
       if (IsAttacked(king_[side], enemy_side)) {
@@ -127,26 +188,52 @@ namespace Sayuri {
       // アルファ値、ベータ値を調べる。
       if (score > alpha) {
         alpha = score;
+        best_move = move;
       }
       if (score >= beta) {
         alpha = beta;
+        score_type = ScoreType::BETA;
         break;
       }
     }
 
+    // トランスポジションテーブルに深さ0で登録。
+    // Null Move探索中の局面は登録しない。
+    if (enable_ttable && !is_null_searching_ && !ShouldBeStopped()
+    && !IsAborted()) {
+      if ((score_type != ScoreType::BETA) && (alpha > original_alpha)) {
+        score_type = ScoreType::EXACT;
+      }
+      table.Add(pos_hash, 0, alpha, score_type, best_move, -1, stand_pad);
+    }
+
     return alpha;
   }
 
+  // 静的評価値を得る。
+  int ChessEngine::GetStaticEval(int material, const TTEntry& tt_entry) {
+    int eval = TT_NO_EVAL;
+    if (tt_entry) eval = tt_entry.eval();
+    if (eval == TT_NO_EVAL) eval = evaluator_.Evaluate(material);
+
+    return eval;
+  }
+
   // 探索する。
   template<NodeType Type>
-  int ChessEngine::Search(Hash pos_hash, int depth, std::uint32_t level,
-  int alpha, int beta, int material, TranspositionTable& table,
-  PVLine& pv_line) {
+  int ChessEngine::Search(int depth, std::uint32_t level, int alpha,
+  int beta, int material, TranspositionTable& table, PVLine& pv_line) {
     // 探索中止の時。
     if (ShouldBeStopped()) return alpha;
 
+    // 上の分岐点がベータカットされて、探索が無駄になった時。
+    if (IsAborted()) {
+      CountAbortedNode();
+      return alpha;
+    }
+
     // ノード数を加算。
-    shared_st_ptr_->num_searched_nodes_++;
+    AddSearchedNodes(1);
 
     // 最大探索数。
     if (level > searched_level_) {
@@ -159,11 +246,11 @@ namespace Sayuri {
     bool is_checked = IsAttacked(king_[side], enemy_side);
 
     // トランスポジションテーブルを調べる。
+    Hash pos_hash = position_key_;
     Move prev_best = 0;
     if (shared_st_ptr_->search_params_ptr_->enable_ttable()) {
-      table.Lock();
       // 前回の繰り返しの最善手を得る。
-      const TTEntry& prev_entry = table.GetEntry(pos_hash, depth - 1);
+      TTEntry prev_entry = table.GetEntry(pos_hash, depth - 1);
       if (prev_entry && (prev_entry.score_type() != ScoreType::ALPHA)) {
         prev_best = prev_entry.best_move();
       }
@@ -171,19 +258,19 @@ namespace Sayuri {
       // 自分の初手と相手の初手の場合(level < 2の場合)は参照しない。
       // 前回の繰り返しの最善手を得る。
       if (level >= 2) {
-        const TTEntry& tt_entry = table.GetEntry(pos_hash, depth);
+        TTEntry tt_entry = table.GetEntry(pos_hash, depth);
         if (tt_entry) {
           int score = tt_entry.score();
           if (tt_entry.score_type() == ScoreType::EXACT) {
             // エントリーが正確な値。
-            if (!(tt_entry.best_move() & CAPTURED_PIECE_MASK)
-            && (level < MAX_PLYS)) {
+            // エントリーの手は取った駒を持たないので、盤面で確認する。
+            Move best_move = tt_entry.best_move();
+            if (!piece_board_[move_to(best_move)] && (level < MAX_PLYS)) {
               // キラームーブをセット。
-              Move best_move = tt_entry.best_move();
               if (shared_st_ptr_->search_params_ptr_->enable_killer()) {
-                shared_st_ptr_->killer_stack_[level][0] = best_move;
+                ordering_st_ptr_->killer_stack_[level][0] = best_move;
                 if (shared_st_ptr_->search_params_ptr_->enable_killer_2()) {
-                  shared_st_ptr_->killer_stack_[level + 2][1] = best_move;
+                  ordering_st_ptr_->killer_stack_[level + 2][1] = best_move;
                 }
               }
             }
@@ -191,18 +278,15 @@ namespace Sayuri {
             pv_line.ply_mate(tt_entry.ply_mate());
             if (score >= beta) {
               pv_line.score(beta);
-              table.Unlock();
               return beta;
             }
 
             if (score <= alpha) {
               pv_line.score(alpha);
-              table.Unlock();
               return alpha;
             }
 
             pv_line.score(score);
-            table.Unlock();
             return score;
           } else if (tt_entry.score_type() == ScoreType::ALPHA) {
             // エントリーがアルファ値。
@@ -210,7 +294,6 @@ namespace Sayuri {
               // アルファ値以下が確定。
               pv_line.score(alpha);
               pv_line.ply_mate(tt_entry.ply_mate());
-              table.Unlock();
               return alpha;
             }
 
@@ -218,14 +301,14 @@ namespace Sayuri {
             if (score < beta) beta = score + 1;
           } else {
             // エントリーがベータ値。
-            if (!(tt_entry.best_move() & CAPTURED_PIECE_MASK)
-            && (level < MAX_PLYS)) {
+            // エントリーの手は取った駒を持たないので、盤面で確認する。
+            Move best_move = tt_entry.best_move();
+            if (!piece_board_[move_to(best_move)] && (level < MAX_PLYS)) {
               // キラームーブをセット。
-              Move best_move = tt_entry.best_move();
               if (shared_st_ptr_->search_params_ptr_->enable_killer()) {
-                shared_st_ptr_->killer_stack_[level][0] = best_move;
+                ordering_st_ptr_->killer_stack_[level][0] = best_move;
                 if (shared_st_ptr_->search_params_ptr_->enable_killer_2()) {
-                  shared_st_ptr_->killer_stack_[level + 2][1] = best_move;
+                  ordering_st_ptr_->killer_stack_[level + 2][1] = best_move;
                 }
               }
             }
@@ -234,7 +317,6 @@ namespace Sayuri {
               // ベータ値以上が確定。
               pv_line.score(beta);
               pv_line.ply_mate(tt_entry.ply_mate());
-              table.Unlock();
               return beta;
             }
 
@@ -243,14 +325,13 @@ namespace Sayuri {
           }
         }
       }
-      table.Unlock();
     }
 
     // 深さが0ならクイース。
     // 限界探索数を超えていてもクイース。
     if ((depth <= 0) || (level >= MAX_PLYS)) {
       // クイース探索ノードに移行するため、ノード数を減らしておく。
-      shared_st_ptr_->num_searched_nodes_--;
+      AddSearchedNodes(-1);
       return Quiesce(depth, level, alpha, beta, material, table);
     }
 
@@ -259,17 +340,17 @@ namespace Sayuri {
       if (shared_st_ptr_->search_params_ptr_->enable_iid()) {
         // 前回の繰り返しの最善手があればIIDしない。
         if (prev_best) {
-          shared_st_ptr_->iid_stack_[level] = prev_best;
+          ordering_st_ptr_->iid_stack_[level] = prev_best;
         } else {
           if (!is_checked && (depth
           >= shared_st_ptr_->search_params_ptr_->iid_limit_depth())) {
             // Internal Iterative Deepening。
             PVLine next_line;
-            Search<NodeType::PV>(pos_hash,
-            shared_st_ptr_->search_params_ptr_->iid_search_depth(), level,
+            Search<NodeType::PV>
+            (shared_st_ptr_->search_params_ptr_->iid_search_depth(), level,
             alpha, beta, material, table, next_line);
 
-            shared_st_ptr_->iid_stack_[level] = next_line.line()[0];
+            ordering_st_ptr_->iid_stack_[level] = next_line.line()[0];
           }
         }
       }
@@ -286,10 +367,14 @@ namespace Sayuri {
 
           is_null_searching_ = true;
           MakeMove(null_move);
+          // 子ノードのエントリーを先読みする。
+          if (shared_st_ptr_->search_params_ptr_->enable_prefetch()) {
+            table.Prefetch(position_key_);
+          }
 
           // Null Move Search。
           PVLine dummy_line;
-          int score = -Search<NodeType::NON_PV>(pos_hash, depth
+          int score = -Search<NodeType::NON_PV>(depth
           - shared_st_ptr_->search_params_ptr_->nmr_search_reduction() - 1,
           level + 1, -(beta), -(beta - 1), -material, table, dummy_line);
 
@@ -303,7 +388,7 @@ namespace Sayuri {
             depth -= null_reduction;
             if ((depth <= 0)) {
               // クイース探索ノードに移行するため、ノード数を減らしておく。
-              shared_st_ptr_->num_searched_nodes_--;
+              AddSearchedNodes(-1);
               return Quiesce(depth, level, alpha, beta, material, table);
             }
           }
@@ -314,9 +399,9 @@ namespace Sayuri {
     // 手を作る。
     MoveMaker& maker = maker_table_[level];
     maker.GenMoves<GenMoveType::ALL>(prev_best,
-    shared_st_ptr_->iid_stack_[level],
-    shared_st_ptr_->killer_stack_[level][0],
-    shared_st_ptr_->killer_stack_[level][1]);
+    iid_stack()[level],
+    killer_stack()[level][0],
+    killer_stack()[level][1]);
 
     // ProbCut。
     if ((Type == NodeType::NON_PV)) {
@@ -335,10 +420,13 @@ namespace Sayuri {
           // 探索。
           for (Move move = maker.PickMove(); move; move = maker.PickMove()) {
             // 次のノードへの準備。
-            Hash next_hash = GetNextHash(pos_hash, move);
             int next_my_material = GetNextMyMaterial(material, move);
 
             MakeMove(move);
+            // 子ノードのエントリーを先読みする。
+            if (shared_st_ptr_->search_params_ptr_->enable_prefetch()) {
+              table.Prefetch(position_key_);
+            }
 
             // 合法手じゃなければ次の手へ。
             if (IsAttacked(king_[side], enemy_side)) {
@@ -347,7 +435,7 @@ namespace Sayuri {
             }
 
             PVLine next_line;
-            int score = -Search<NodeType::NON_PV>(next_hash, prob_depth - 1,
+            int score = -Search<NodeType::NON_PV>(prob_depth - 1,
             level + 1, -prob_beta, -(prob_beta - 1), -next_my_material, table,
             next_line);
 
@@ -367,19 +455,18 @@ namespace Sayuri {
 
                 // キラームーブ。
                 if (shared_st_ptr_->search_params_ptr_->enable_killer()) {
-                  shared_st_ptr_->killer_stack_[level][0] = move;
+                  ordering_st_ptr_->killer_stack_[level][0] = move;
                   if (shared_st_ptr_->search_params_ptr_->enable_killer_2()) {
-                    shared_st_ptr_->killer_stack_[level + 2][1] = move;
+                    ordering_st_ptr_->killer_stack_[level + 2][1] = move;
                   }
                 }
 
                 // ヒストリー。
                 if (shared_st_ptr_->search_params_ptr_->enable_history()) {
-                  shared_st_ptr_->history_[side][from][to] += depth * depth;
-                  if (shared_st_ptr_->history_[side][from][to]
-                  > shared_st_ptr_->history_max_) {
-                    shared_st_ptr_->history_max_ =
-                    shared_st_ptr_->history_[side][from][to];
+                  ordering_st_ptr_->history_[side][from][to] += depth * depth;
+                  if (history()[side][from][to] > history_max()) {
+                    ordering_st_ptr_->history_max_ =
+                    history()[side][from][to];
                   }
                 }
               }
@@ -387,9 +474,9 @@ namespace Sayuri {
               // トランスポジションテーブルに登録。
               // Null Move Reductionされていた場合、容量節約のため登録しない。
               if (shared_st_ptr_->search_params_ptr_->enable_ttable()) {
-                if (!null_reduction && !ShouldBeStopped()) {
+                if (!null_reduction && !ShouldBeStopped() && !IsAborted()) {
                   table.Add(pos_hash, depth, beta, ScoreType::BETA,
-                  pv_line.line()[0], pv_line.ply_mate());
+                  pv_line.line()[0], pv_line.ply_mate(), TT_NO_EVAL);
                 }
               }
 
@@ -413,28 +500,13 @@ namespace Sayuri {
     bool has_legal_move = false;
     int margin = GetMargin(depth);
 
-    // 仕事の生成。
+    // 仕事。
+    // 実際に分岐するまでは準備もしないし、ロックもしない。
     std::mutex mutex;
-    PositionRecord record(*this);
     Job& job = job_table_[level];
-    job.Init(maker);
-    job.mutex_ptr_ = &mutex;
-    job.record_ptr_ = &record;
-    job.node_type_ = Type;
-    job.pos_hash_ = pos_hash;
-    job.depth_ = depth;
-    job.level_ = level;
-    job.alpha_ptr_ = &alpha;
-    job.beta_ptr_ = &beta;
-    job.table_ptr_ = &table;
-    job.pv_line_ptr_ = &pv_line;
-    job.is_null_searching_ = is_null_searching_;
-    job.null_reduction_ = null_reduction;
-    job.score_type_ptr_ = &score_type;
-    job.material_ = material;
-    job.is_checked_ = is_checked;
-    job.num_all_moves_ = num_all_moves;
-    job.has_legal_move_ptr_ = &has_legal_move;
+    bool is_split_point = false;
+    Job* parent_job_ptr = active_job_ptr_;
+    HelperQueue& helper_queue = *(shared_st_ptr_->helper_queue_ptr_);
 
     // パラメータ保存。
     // YBWC。
@@ -457,7 +529,7 @@ namespace Sayuri {
     history_pruning_move_threshold < history_pruning_after 
     ? history_pruning_after : history_pruning_move_threshold;
 
-    std::uint64_t history_pruning_threshold = shared_st_ptr_->history_max_
+    std::uint64_t history_pruning_threshold = history_max()
     * shared_st_ptr_->search_params_ptr_->history_pruning_threshold();
 
     int history_pruning_reduction =
@@ -491,17 +563,46 @@ namespace Sayuri {
       }
 
       // 別スレッドに助けを求める。(YBWC)
-      if ((depth >= ybwc_limit_depth) && (num_moves > ybwc_after)) {
-        shared_st_ptr_->helper_queue_ptr_->Help(job);
+      // 手伝えるスレッドがいる時に初めて、仕事を準備して分岐点にする。
+      // Lazy SMPのヘルパーは独自に探索するので、分岐しない。
+      if ((depth >= ybwc_limit_depth) && (num_moves > ybwc_after)
+      && !is_lazy_smp_helper_ && helper_queue.CanHelp(parent_job_ptr)) {
+        if (!is_split_point) {
+          record_table_[level] = PositionRecord(*this);
+          job.Init(maker, num_moves, thread_id_);
+          job.mutex_ptr_ = &mutex;
+          job.record_ptr_ = &(record_table_[level]);
+          job.node_type_ = Type;
+          job.depth_ = depth;
+          job.level_ = level;
+          job.alpha_ptr_ = &alpha;
+          job.beta_ptr_ = &beta;
+          job.table_ptr_ = &table;
+          job.pv_line_ptr_ = &pv_line;
+          job.is_null_searching_ = is_null_searching_;
+          job.null_reduction_ = null_reduction;
+          job.score_type_ptr_ = &score_type;
+          job.material_ = material;
+          job.is_checked_ = is_checked;
+          job.num_all_moves_ = num_all_moves;
+          job.has_legal_move_ptr_ = &has_legal_move;
+          job.parent_ptr_ = parent_job_ptr;
+
+          // 子ノードで公開する仕事の親にする。
+          active_job_ptr_ = &job;
+          is_split_point = true;
+        }
+        helper_queue.Help(job);
       }
 
-      // 次のハッシュ。
-      Hash next_hash = GetNextHash(pos_hash, move);
-
       // 次の自分のマテリアル。
       int next_my_material = GetNextMyMaterial(material, move);
 
       MakeMove(move);
+      // 子ノードのエントリーを先読みする。
+      if (shared_st_ptr_->search_params_ptr_->enable_prefetch()) {
+        table.Prefetch(position_key_);
+      }
 
       // 合法手じゃなければ次の手へ。
       if (IsAttacked(king_[side], enemy_side)) {
@@ -512,7 +613,7 @@ namespace Sayuri {
       // 合法手があったのでフラグを立てる。
       has_legal_move = true;
 
-      num_moves = job.Count();
+      num_moves = is_split_point ? job.Count() : num_moves + 1;
 
       // Futility Pruning。
       if (enable_futility_pruning) {
@@ -539,8 +640,8 @@ namespace Sayuri {
       bool is_hp_or_lmr_ok = false;
       if (!is_checked && !null_reduction
       && !(move & (CAPTURED_PIECE_MASK | PROMOTION_MASK))
-      && !EqualMove(move, shared_st_ptr_->killer_stack_[level][0])
-      && !EqualMove(move, shared_st_ptr_->killer_stack_[level][1])) {
+      && !EqualMove(move, killer_stack()[level][0])
+      && !EqualMove(move, killer_stack()[level][1])) {
         is_hp_or_lmr_ok = true;
       }
 
@@ -549,7 +650,7 @@ namespace Sayuri {
         if (enable_history_pruning) {
           if (is_hp_or_lmr_ok && (new_depth >= history_pruning_limit_depth)
           && (num_moves > history_pruning_move_threshold)
-          && (shared_st_ptr_->history_[side][from][to]
+          && (history()[side][from][to]
           < history_pruning_threshold)) {
             new_depth -= history_pruning_reduction;
           }
@@ -561,7 +662,7 @@ namespace Sayuri {
       if (enable_lmr) {
         if (is_hp_or_lmr_ok && (new_depth >= lmr_limit_depth)
         && (num_moves > lmr_threshold)) {
-          score = -Search<NodeType::NON_PV>(next_hash,
+          score = -Search<NodeType::NON_PV>(
           new_depth - lmr_search_reduction - 1, level + 1, -(temp_alpha + 1),
           -temp_alpha, -next_my_material, table, next_line);
         } else {
@@ -577,19 +678,19 @@ namespace Sayuri {
         // PVSearch。
         if ((num_moves <= 1) || (Type == NodeType::NON_PV)) {
           // フルウィンドウで探索。
-          score = -Search<Type>(next_hash, new_depth - 1, level + 1,
+          score = -Search<Type>(new_depth - 1, level + 1,
           -temp_beta, -temp_alpha, -next_my_material, table, next_line);
         } else {
           // PV発見後のPVノード。
           // ゼロウィンドウ探索。
-          score = -Search<NodeType::NON_PV>(next_hash, new_depth - 1,
+          score = -Search<NodeType::NON_PV>(new_depth - 1,
           level + 1, -(temp_alpha + 1), -temp_alpha, -next_my_material, table,
           next_line);
 
           if (score > temp_alpha) {
             // fail lowならず。
             // フルウィンドウで再探索。
-            score = -Search<NodeType::PV>(next_hash, new_depth - 1, level + 1,
+            score = -Search<NodeType::PV>(new_depth - 1, level + 1,
             -temp_beta, -temp_alpha, -next_my_material, table, next_line);
           }
         }
@@ -607,7 +708,10 @@ namespace Sayuri {
 
       UnmakeMove(move);
 
-      mutex.lock();  // ロック。
+      // ヘルパーか上の分岐点がベータカットしていれば、結果は使えない。
+      if (IsAborted()) break;
+
+      if (is_split_point) mutex.lock();  // ロック。
 
       // アルファ値を更新。
       if (score > alpha) {
@@ -628,38 +732,48 @@ namespace Sayuri {
         // 評価値の種類をセット。
         score_type = ScoreType::BETA;
 
+        // 手の並べ替えの良さを調べるために数える。
+        CountFailHigh(num_moves <= 1);
+
         // 取らない手。
         if (!(move & CAPTURED_PIECE_MASK)) {
           // キラームーブ。
           if (shared_st_ptr_->search_params_ptr_->enable_killer()) {
-            shared_st_ptr_->killer_stack_[level][0] = move;
+            ordering_st_ptr_->killer_stack_[level][0] = move;
             if (shared_st_ptr_->search_params_ptr_->enable_killer_2()) {
-              shared_st_ptr_->killer_stack_[level + 2][1] = move;
+              ordering_st_ptr_->killer_stack_[level + 2][1] = move;
             }
           }
 
           // ヒストリー。
           if (shared_st_ptr_->search_params_ptr_->enable_history()) {
-            shared_st_ptr_->history_[side][from][to] += depth * depth;
-            if (shared_st_ptr_->history_[side][from][to]
-            > shared_st_ptr_->history_max_) {
-              shared_st_ptr_->history_max_ =
-              shared_st_ptr_->history_[side][from][to];
+            ordering_st_ptr_->history_[side][from][to] += depth * depth;
+            if (history()[side][from][to] > history_max()) {
+              ordering_st_ptr_->history_max_ =
+              history()[side][from][to];
             }
           }
         }
 
-        // ベータカット。
-        mutex.unlock();  // ロック解除。
+        // ベータカット。ヘルパーの探索も打ち切らせる。
+        if (is_split_point) {
+          job.Abort();
+          mutex.unlock();  // ロック解除。
+        }
         alpha = beta;
         break;
       }
 
-      mutex.unlock();  // ロック解除。
+      if (is_split_point) mutex.unlock();  // ロック解除。
     }
 
-    // スレッドを合流。
-    job.WaitForHelpers();
+    // 分岐点になっていれば、公開をやめて、
+    // ヘルパーを手伝いながらスレッドを合流。
+    if (is_split_point) {
+      helper_queue.Withdraw(job);
+      HelpHelpers(job);
+      active_job_ptr_ = parent_job_ptr;
+    }
 
 
     // このノードでゲーム終了だった場合。
@@ -686,9 +800,10 @@ namespace Sayuri {
     // Null Move探索中の局面は登録しない。
     // Null Move Reductionされていた場合、容量節約のため登録しない。
     if (shared_st_ptr_->search_params_ptr_->enable_ttable()) {
-      if (!is_null_searching_ && !null_reduction && !ShouldBeStopped()) {
+      if (!is_null_searching_ && !null_reduction && !ShouldBeStopped()
+      && !IsAborted()) {
         table.Add(pos_hash, depth, alpha, score_type,
-        pv_line.line()[0], pv_line.ply_mate());
+        pv_line.line()[0], pv_line.ply_mate(), TT_NO_EVAL);
       }
     }
 
@@ -697,76 +812,85 @@ namespace Sayuri {
     return alpha;
   }
   // 実体化。
-  template int ChessEngine::Search<NodeType::PV>(Hash pos_hash,
-  int depth, std::uint32_t level, int alpha, int beta, int material,
+  template int ChessEngine::Search<NodeType::PV>(int depth,
+  std::uint32_t level, int alpha, int beta, int material,
   TranspositionTable& table, PVLine& pv_line);
-  template int ChessEngine::Search<NodeType::NON_PV>(Hash pos_hash,
-  int depth, std::uint32_t level, int alpha, int beta, int material,
+  template int ChessEngine::Search<NodeType::NON_PV>(int depth,
+  std::uint32_t level, int alpha, int beta, int material,
   TranspositionTable& table, PVLine& pv_line);
 
   // 探索のルート。
-  PVLine ChessEngine::SearchRoot(TranspositionTable& table,
+  PVLine ChessEngine::SearchRoot(bool use_lazy_smp, TranspositionTable& table,
   const std::vector<Move>& moves_to_search, UCIShell& shell) {
     // 初期化。
     searched_level_ = 0;
-    shared_st_ptr_->num_searched_nodes_ = 0;
-    shared_st_ptr_->start_time_ = SysClock::now();
-    for (Side side = 0; side < NUM_SIDES; side++) {
-      for (Square from = 0; from < NUM_SQUARES; from++) {
-        for (Square to = 0; to < NUM_SQUARES; to++) {
-          shared_st_ptr_->history_[side][from][to] = 0;
-        }
-      }
-    }
-    for (std::uint32_t i = 0; i < (MAX_PLYS + 1); i++) {
-      shared_st_ptr_->iid_stack_[i] = 0;
-      shared_st_ptr_->killer_stack_[i][0] = 0;
-      shared_st_ptr_->killer_stack_[i][1] = 0;
-      shared_st_ptr_->killer_stack_[i + 2][0] = 0;
-      shared_st_ptr_->killer_stack_[i + 2][1] = 0;
-    }
-    shared_st_ptr_->history_max_ = 1;
+    // ノード数のカウンターはこのスレッドと探索用スレッドの分を用意する。
+    shared_st_ptr_->ResetNodeCounters(static_cast<int>(child_vec_.size()) + 1);
+    shared_st_ptr_->start_time_ = SteadyClock::now();
+    ordering_st_ptr_->Clear();
+    if (!merged_st_ptr_) merged_st_ptr_.Reset();
+    merged_st_ptr_->Clear();
     shared_st_ptr_->stop_now_ = false;
     shared_st_ptr_->i_depth_ = 1;
     is_null_searching_ = false;
 
     // スレッドの準備。
-    shared_st_ptr_->helper_queue_ptr_.reset(new HelperQueue());
-    for (auto& thread : thread_vec_) {
-      thread =
-      std::thread(&ChessEngine::ThreadYBWC, this, std::ref(shell));
+    // Lazy SMPの場合、このスレッドと1本目の探索用スレッドがYBWCで探索し、
+    // 残りのスレッドはLazy SMPのヘルパーにする。
+    // Lazy SMPのヘルパーは分岐点を公開しないので、
+    // YBWCのヘルパーが引き込まれることはない。
+    // スレッド番号は0がこのスレッド、1からが探索用スレッド。
+    shared_st_ptr_->helper_queue_ptr_.reset
+    (new HelperQueue(static_cast<int>(child_vec_.size()) + 1));
+    PositionRecord root_record(*this);
+    std::size_t num_lazy_helpers = use_lazy_smp ? child_vec_.size() - 1 : 0;
+    std::vector<PVLine> lazy_pv_lines(num_lazy_helpers);
+    std::vector<int> lazy_depths(num_lazy_helpers, 0);
+    for (auto& child_ptr : child_vec_) {
+      child_ptr->shared_st_ptr_ = shared_st_ptr_;
+      child_ptr->ordering_st_ptr_->Clear();
     }
+    thread_pool_.Start([&](int index) {
+      if (index == 0 || !use_lazy_smp) {
+        ThreadYBWC(shell, index + 1);
+      } else {
+        ThreadLazySMP(index, root_record, table, moves_to_search,
+        lazy_pv_lines[index - 1], lazy_depths[index - 1]);
+      }
+    });
 
     // Iterative Deepening。
     int level = 0;
-    Hash pos_hash = GetCurrentHash();
+    Hash pos_hash = position_key_;
     int material = GetMaterial(to_move_);
     int alpha = -MAX_VALUE;
     int beta = MAX_VALUE;
     Side side = to_move_;
     Side enemy_side = side ^ 0x3;
     PVLine pv_line;
-    TimePoint now = SysClock::now();
-    TimePoint next_print_info_time = now + Chrono::milliseconds(1000);
+    SteadyTimePoint now = SteadyClock::now();
+    SteadyTimePoint next_print_info_time =
+    now + Chrono::milliseconds(1000);
     MoveMaker& maker = maker_table_[level];
     bool is_checked = IsAttacked(king_[side], enemy_side);
     bool found_mate = false;
+    int completed_depth = 0;
     for (shared_st_ptr_->i_depth_ = 1; shared_st_ptr_->i_depth_ <= MAX_PLYS;
     shared_st_ptr_->i_depth_++) {
       // 探索終了。
       if (ShouldBeStopped()) break;
 
       // ノードを加算。
-      shared_st_ptr_->num_searched_nodes_++;
+      AddSearchedNodes(1);
 
       // メイトをすでに見つけていたら探索しない。
       if (found_mate) {
         Chrono::milliseconds time =
         Chrono::duration_cast<Chrono::milliseconds>
-        (SysClock::now() - shared_st_ptr_->start_time_);
+        (SteadyClock::now() - shared_st_ptr_->start_time_);
 
         shell.PrintPVInfo(shared_st_ptr_->i_depth_, 0, pv_line.score(),
-        time, shared_st_ptr_->num_searched_nodes_, pv_line);
+        time, shared_st_ptr_->CountSearchedNodes(), pv_line);
 
         continue;
       }
@@ -791,13 +915,11 @@ namespace Sayuri {
       // 前回の繰り返しの最善手を得る。
       Move prev_best = 0;
       if (shared_st_ptr_->search_params_ptr_->enable_ttable()) {
-        table.Lock();
-        const TTEntry& prev_entry =
+        TTEntry prev_entry =
         table.GetEntry(pos_hash, shared_st_ptr_->i_depth_ - 1);
         if (prev_entry && (prev_entry.score_type() != ScoreType::ALPHA)) {
           prev_best = prev_entry.best_move();
         }
-        table.Unlock();
       }
 
       // Check Extension。
@@ -810,17 +932,16 @@ namespace Sayuri {
       std::mutex mutex;
       PositionRecord record(*this);
       int num_all_moves = maker.GenMoves<GenMoveType::ALL>(prev_best,
-      shared_st_ptr_->iid_stack_[level],
-      shared_st_ptr_->killer_stack_[level][0],
-      shared_st_ptr_->killer_stack_[level][1]);
+      iid_stack()[level],
+      killer_stack()[level][0],
+      killer_stack()[level][1]);
       ScoreType score_type = ScoreType::EXACT;
       bool has_legal_move = false;
       Job& job = job_table_[level];
-      job.Init(maker);
+      job.Init(maker, 0, thread_id_);
       job.mutex_ptr_ = &mutex;
       job.record_ptr_ = &record;
       job.node_type_ = NodeType::PV;
-      job.pos_hash_ = pos_hash;
       job.depth_ = depth;
       job.level_ = level;
       job.alpha_ptr_ = &alpha;
@@ -837,10 +958,19 @@ namespace Sayuri {
       job.has_legal_move_ptr_ = &has_legal_move;
       job.moves_to_search_ptr_ = &moves_to_search;
       job.next_print_info_time_ptr_ = &next_print_info_time;
+      job.parent_ptr_ = nullptr;
 
       // ヘルプして待つ。
       shared_st_ptr_->helper_queue_ptr_->HelpRoot(job);
       job.WaitForHelpers();
+      shared_st_ptr_->helper_queue_ptr_->Withdraw(job);
+
+      // 中断されずに探索し終えた深さを記録。
+      if (!ShouldBeStopped()) completed_depth = shared_st_ptr_->i_depth_;
+
+      // 次の繰り返しのために、YBWCのスレッドのヒストリーをまとめる。
+      // Lazy SMPのヘルパーはまだ探索しているので触らない。
+      if (!use_lazy_smp) MergeOrderingTables();
 
       // メイトを見つけたらフラグを立てる。
       // 直接ループを抜けない理由は、depth等の終了条件対策。
@@ -849,39 +979,92 @@ namespace Sayuri {
       }
     }
 
-    // スレッドをジョイン。
+    // スレッドの仕事が終わるのを待つ。
+    // Lazy SMPのヘルパーは探索が止まるまで独自に探索を続ける。
     shared_st_ptr_->helper_queue_ptr_->ReleaseHelpers();
-    for (auto& thread : thread_vec_) {
-      if (thread.joinable()) {
-        thread.join();
+    if (use_lazy_smp) WaitForStop();
+    thread_pool_.Wait();
+
+    // Lazy SMPの場合、各スレッドの最善手に投票して手を決める。
+    // 票は深さと、最低の評価値からの差に比例させる。
+    if (use_lazy_smp) {
+      std::vector<const PVLine*> lines {&pv_line};
+      std::vector<int> depths {completed_depth};
+      for (std::size_t i = 0; i < num_lazy_helpers; i++) {
+        if ((lazy_depths[i] > 0) && (lazy_pv_lines[i].length() >= 1)) {
+          lines.push_back(&lazy_pv_lines[i]);
+          depths.push_back(lazy_depths[i]);
+        }
+      }
+
+      int min_score = MAX_VALUE;
+      for (auto line_ptr : lines) {
+        if (line_ptr->score() < min_score) min_score = line_ptr->score();
+      }
+
+      std::vector<std::int64_t> votes(lines.size(), 0);
+      for (std::size_t i = 0; i < lines.size(); i++) {
+        if (lines[i]->length() < 1) continue;
+        std::int64_t vote = static_cast<std::int64_t>
+        (lines[i]->score() - min_score + LAZY_SMP_VOTE_BASE)
+        * (depths[i] >= 1 ? depths[i] : 1);
+        Move move_i = lines[i]->line()[0];
+        for (std::size_t j = 0; j < lines.size(); j++) {
+          Move move_j = lines[j]->line()[0];
+          if ((lines[j]->length() >= 1) && EqualMove(move_i, move_j)) {
+            votes[j] += vote;
+          }
+        }
+      }
+
+      // 票が一番多い手の中で、一番深く探索したスレッドのPVラインを使う。
+      std::size_t best = 0;
+      for (std::size_t i = 1; i < lines.size(); i++) {
+        if ((votes[i] > votes[best])
+        || ((votes[i] == votes[best]) && (depths[i] > depths[best]))) {
+          best = i;
+        }
+      }
+      if (best != 0) {
+        pv_line = *(lines[best]);
+
+        Chrono::milliseconds time =
+        Chrono::duration_cast<Chrono::milliseconds>
+        (SteadyClock::now() - shared_st_ptr_->start_time_);
+        shell.PrintPVInfo(depths[best], 0, pv_line.score(), time,
+        shared_st_ptr_->CountSearchedNodes(), pv_line);
       }
     }
 
     // 最後に情報を送る。
-    now = SysClock::now();
+    now = SteadyClock::now();
     shell.PrintOtherInfo
     (Chrono::duration_cast<Chrono::milliseconds>
     (now - (shared_st_ptr_->start_time_)),
-    shared_st_ptr_->num_searched_nodes_, table.GetUsedPermill());
-
+    shared_st_ptr_->CountSearchedNodes(), table.GetUsedPermill());
+    const HelperQueue& queue = *(shared_st_ptr_->helper_queue_ptr_);
+    shell.PrintHelperQueueInfo(queue.num_steals(),
+    queue.num_failed_steals(), queue.idle_time(),
+    shared_st_ptr_->CountAbortedNodes());
+    shell.PrintMoveOrderingInfo(shared_st_ptr_->CountFailHighs(),
+    shared_st_ptr_->CountFirstFailHighs());
 
     // 探索終了したけど、まだ思考を止めてはいけない場合、関数を終了しない。
-    while (!ShouldBeStopped()) continue;
+    WaitForStop();
 
     return pv_line;
   }
 
   // 探索用子スレッド。
-  void ChessEngine::ThreadYBWC(UCIShell& shell) {
-    // 子エンジンを作る。
-    mutex_.lock();
-    std::unique_ptr<ChessEngine> child_ptr(new ChessEngine());
-    child_ptr->shared_st_ptr_ = shared_st_ptr_;
-    mutex_.unlock();
+  void ChessEngine::ThreadYBWC(UCIShell& shell, int thread_id) {
+    // スレッドの子エンジン。
+    ChessEngine* child_ptr = child_vec_[thread_id - 1].get();
 
     // 仕事ループ。
+    // この関数はマスターのメンバだが、探索用スレッドで動くので、
+    // 中止の判定は子エンジンでする。
     while (true) {
-      if (ShouldBeStopped()) break;
+      if (child_ptr->ShouldBeStopped()) break;
 
       // 仕事を拾う。
       Job* job_ptr = child_ptr->shared_st_ptr_->helper_queue_ptr_->GetJob();
@@ -895,6 +1078,9 @@ namespace Sayuri {
         // Null Move探索中かどうかをセット。
         child_ptr->is_null_searching_ = job_ptr->is_null_searching_;
 
+        // この仕事の下で公開する仕事の親にする。
+        child_ptr->active_job_ptr_ = job_ptr;
+
         if (job_ptr->level_ <= 0) {
           // ルートノード。
           child_ptr->SearchRootParallel(*job_ptr, shell);
@@ -906,8 +1092,231 @@ namespace Sayuri {
             child_ptr->SearchParallel<NodeType::NON_PV>(*job_ptr);
           }
         }
+        child_ptr->active_job_ptr_ = nullptr;
+      }
+    }
+  }
+
+  // Lazy SMP探索用スレッド。
+  void ChessEngine::ThreadLazySMP(int index, const PositionRecord& record,
+  TranspositionTable& table, const std::vector<Move>& moves_to_search,
+  PVLine& pv_line, int& depth) {
+    // スレッドの子エンジン。
+    ChessEngine* child_ptr = child_vec_[index].get();
+
+    // 駒の配置を読み込んで探索。
+    // YBWCのヘルパーを分岐点に引き込まないように、分岐させない。
+    child_ptr->LoadRecord(record);
+    child_ptr->is_lazy_smp_helper_ = true;
+    child_ptr->SearchRootLazySMP(index, table, moves_to_search, pv_line,
+    depth);
+    child_ptr->is_lazy_smp_helper_ = false;
+  }
+
+  // ヘルパーを手伝いながら合流を待つ。(Helpful Master)
+  void ChessEngine::HelpHelpers(Job& job) {
+    HelperQueue& queue = *(shared_st_ptr_->helper_queue_ptr_);
+    Chrono::nanoseconds idle_time(0);
+    bool has_helped = false;
+    bool is_null_searching = is_null_searching_;
+
+    queue.AddWaitingOwners(1);
+    while (true) {
+      // 自分の分岐点の下にある仕事なら、自分の子ノードのためにもなる。
+      // ベータカットされていれば、下の仕事は全部無駄。
+      Job* job_ptr = job.IsAborted() ? nullptr : queue.GetJobUnder(job);
+      if (job_ptr) {
+        LoadRecord(*(job_ptr->record_ptr_));
+        is_null_searching_ = job_ptr->is_null_searching_;
+        active_job_ptr_ = job_ptr;
+        if (job_ptr->node_type_ == NodeType::PV) {
+          SearchParallel<NodeType::PV>(*job_ptr);
+        } else {
+          SearchParallel<NodeType::NON_PV>(*job_ptr);
+        }
+        has_helped = true;
+        continue;
+      }
+
+      // 仕事が無ければ、ヘルパーの合流か新しい仕事を待つ。
+      SteadyTimePoint start = SteadyClock::now();
+      bool is_finished = job.WaitForHelpersOrJob();
+      idle_time += SteadyClock::now() - start;
+      if (is_finished) break;
+    }
+    queue.AddWaitingOwners(-1);
+    queue.AddIdleTime(idle_time);
+
+    // 自分の分岐点の局面に戻す。
+    if (has_helped) {
+      LoadRecord(*(job.record_ptr_));
+      is_null_searching_ = is_null_searching;
+      active_job_ptr_ = &job;
+    }
+  }
+
+  // 各スレッドのヒストリーの増えた分を足し合わせて、全スレッドに配る。
+  void ChessEngine::MergeOrderingTables() {
+    if (child_vec_.empty()) return;
+
+    // 前回配った値からの増分を足すので、同じ経験を二重に数えない。
+    // 仕事の無かったスレッドは何も足さない。
+    // キラームーブとIIDの手はレベルごとの局所的な情報なので、まとめない。
+    std::uint64_t history_max = 1;
+    for (Side side = 0; side < NUM_SIDES; side++) {
+      for (Square from = 0; from < NUM_SQUARES; from++) {
+        for (Square to = 0; to < NUM_SQUARES; to++) {
+          std::uint64_t base = merged_st_ptr_->history_[side][from][to];
+          std::uint64_t merged = history()[side][from][to];
+          for (auto& child_ptr : child_vec_) {
+            merged += child_ptr->history()[side][from][to] - base;
+          }
+
+          merged_st_ptr_->history_[side][from][to] = merged;
+          ordering_st_ptr_->history_[side][from][to] = merged;
+          for (auto& child_ptr : child_vec_) {
+            child_ptr->ordering_st_ptr_->history_[side][from][to] = merged;
+          }
+          if (merged > history_max) history_max = merged;
+        }
       }
     }
+
+    ordering_st_ptr_->history_max_ = history_max;
+    for (auto& child_ptr : child_vec_) {
+      child_ptr->ordering_st_ptr_->history_max_ = history_max;
+    }
+  }
+
+  // Lazy SMPのヘルパーのルート探索。
+  void ChessEngine::SearchRootLazySMP(int index, TranspositionTable& table,
+  const std::vector<Move>& moves_to_search, PVLine& pv_line, int& depth) {
+    // 初期化。
+    searched_level_ = 0;
+    is_null_searching_ = false;
+
+    std::uint32_t level = 0;
+    Hash pos_hash = position_key_;
+    int material = GetMaterial(to_move_);
+    Side side = to_move_;
+    Side enemy_side = side ^ 0x3;
+    MoveMaker& maker = maker_table_[level];
+    bool is_checked = IsAttacked(king_[side], enemy_side);
+
+    // 奇数番のヘルパーは1つ深い所から始めて、
+    // 各深さを探索するスレッドの数をばらけさせる。
+    for (int i_depth = 1 + (index % 2); i_depth <= static_cast<int>(MAX_PLYS);
+    i_depth++) {
+      if (ShouldBeStopped()) break;
+
+      // 前回の繰り返しの最善手を得る。
+      Move prev_best = 0;
+      if (shared_st_ptr_->search_params_ptr_->enable_ttable()) {
+        TTEntry prev_entry = table.GetEntry(pos_hash, i_depth - 1);
+        if (prev_entry && (prev_entry.score_type() != ScoreType::ALPHA)) {
+          prev_best = prev_entry.best_move();
+        }
+      }
+
+      // 合法手を並べる。
+      std::vector<Move> root_moves;
+      maker.GenMoves<GenMoveType::ALL>(prev_best, 0, 0, 0);
+      for (Move move = maker.PickMove(); move; move = maker.PickMove()) {
+        if (!(moves_to_search.empty())) {
+          bool hit = false;
+          for (auto move_2 : moves_to_search) {
+            if (EqualMove(move_2, move)) {
+              hit = true;
+              break;
+            }
+          }
+          if (!hit) continue;
+        }
+
+        MakeMove(move);
+        if (!IsAttacked(king_[side], enemy_side)) root_moves.push_back(move);
+        UnmakeMove(move);
+      }
+      if (root_moves.empty()) break;
+
+      // 最善手候補以外の手の順番を番号分ずらす。
+      if (root_moves.size() > 2) {
+        std::size_t shift = index % (root_moves.size() - 1);
+        std::rotate(root_moves.begin() + 1, root_moves.begin() + 1 + shift,
+        root_moves.end());
+      }
+
+      // Check Extension。
+      int search_depth = i_depth;
+      if (is_checked) search_depth += 1;
+
+      // PVSearch。
+      int alpha = -MAX_VALUE;
+      int beta = MAX_VALUE;
+      PVLine temp_line;
+      bool is_completed = true;
+      for (std::size_t i = 0; i < root_moves.size(); i++) {
+        Move move = root_moves[i];
+        int next_my_material = GetNextMyMaterial(material, move);
+
+        MakeMove(move);
+        // 子ノードのエントリーを先読みする。
+        if (shared_st_ptr_->search_params_ptr_->enable_prefetch()) {
+          table.Prefetch(position_key_);
+        }
+
+        int score = 0;
+        PVLine next_line;
+        if (i == 0) {
+          score = -Search<NodeType::PV>(search_depth - 1, level + 1, -beta,
+          -alpha, -next_my_material, table, next_line);
+        } else {
+          score = -Search<NodeType::NON_PV>(search_depth - 1, level + 1,
+          -(alpha + 1), -alpha, -next_my_material, table, next_line);
+          if (score > alpha) {
+            score = -Search<NodeType::PV>(search_depth - 1, level + 1, -beta,
+            -alpha, -next_my_material, table, next_line);
+          }
+        }
+
+        // 同じ局面の繰り返しは0点。
+        for (auto& position : shared_st_ptr_->position_history_) {
+          if (position == *this) {
+            score = SCORE_DRAW;
+            break;
+          }
+        }
+
+        UnmakeMove(move);
+
+        if (ShouldBeStopped()) {
+          is_completed = false;
+          break;
+        }
+
+        if (score > alpha) {
+          alpha = score;
+          temp_line.SetMove(move);
+          temp_line.Insert(next_line);
+          temp_line.score(score);
+        }
+      }
+
+      // 途中で止められた深さの結果は使わない。
+      if (!is_completed) break;
+
+      // トランスポジションテーブルに登録。
+      if (shared_st_ptr_->search_params_ptr_->enable_ttable()) {
+        table.Add(pos_hash, search_depth, alpha, ScoreType::EXACT,
+        temp_line.line()[0], temp_line.ply_mate(), TT_NO_EVAL);
+      }
+
+      pv_line = temp_line;
+      depth = i_depth;
+
+      // メイトを見つけたらこれ以上深く探索しない。
+      if (temp_line.ply_mate() >= 0) break;
+    }
   }
 
   // 並列探索。
@@ -940,7 +1349,7 @@ namespace Sayuri {
     history_pruning_move_threshold < history_pruning_after
     ? history_pruning_after : history_pruning_move_threshold;
 
-    std::uint64_t history_pruning_threshold = shared_st_ptr_->history_max_
+    std::uint64_t history_pruning_threshold = history_max()
     * shared_st_ptr_->search_params_ptr_->history_pruning_threshold();
 
     int history_pruning_reduction =
@@ -978,13 +1387,14 @@ namespace Sayuri {
         shared_st_ptr_->helper_queue_ptr_->Help(job);
       }
 
-      // 次のハッシュ。
-      Hash next_hash = GetNextHash(job.pos_hash_, move);
-
       // 次の局面のマテリアルを得る。
       int next_my_material = GetNextMyMaterial(job.material_, move);
 
       MakeMove(move);
+      // 子ノードのエントリーを先読みする。
+      if (shared_st_ptr_->search_params_ptr_->enable_prefetch()) {
+        job.table_ptr_->Prefetch(position_key_);
+      }
 
       // 合法手じゃなければ次の手へ。
       if (IsAttacked(king_[side], enemy_side)) {
@@ -1022,8 +1432,8 @@ namespace Sayuri {
       bool is_hp_or_lmr_ok = false;
       if (!(job.is_checked_) && !(job.null_reduction_)
       && !(move & (CAPTURED_PIECE_MASK | PROMOTION_MASK))
-      && !EqualMove(move, shared_st_ptr_->killer_stack_[job.level_][0])
-      && !EqualMove(move, shared_st_ptr_->killer_stack_[job.level_][1])) {
+      && !EqualMove(move, killer_stack()[job.level_][0])
+      && !EqualMove(move, killer_stack()[job.level_][1])) {
         is_hp_or_lmr_ok = true;
       }
 
@@ -1032,7 +1442,7 @@ namespace Sayuri {
         if (enable_history_pruning) {
           if (is_hp_or_lmr_ok && (new_depth >= history_pruning_limit_depth)
           && (num_moves > history_pruning_move_threshold)
-          && (shared_st_ptr_->history_[side][from][to]
+          && (history()[side][from][to]
           < history_pruning_threshold)) {
             new_depth -= history_pruning_reduction;
           }
@@ -1044,7 +1454,7 @@ namespace Sayuri {
       if (enable_lmr) {
         if (is_hp_or_lmr_ok && (new_depth >= lmr_limit_depth)
         && (num_moves > lmr_threshold)) {
-          score = -Search<NodeType::NON_PV>(next_hash,
+          score = -Search<NodeType::NON_PV>(
           new_depth - lmr_search_reduction - 1, job.level_ + 1,
           -(temp_alpha + 1), -temp_alpha, -next_my_material, *(job.table_ptr_),
           next_line);
@@ -1061,19 +1471,19 @@ namespace Sayuri {
         // PVSearch。
         if ((num_moves <= 1) || (Type == NodeType::NON_PV)) {
           // フルウィンドウ探索。
-          score = -Search<Type>(next_hash, new_depth - 1,
+          score = -Search<Type>(new_depth - 1,
           job.level_ + 1, -temp_beta, -temp_alpha, -next_my_material,
           *(job.table_ptr_), next_line);
         } else {
           // PV発見後。
           // ゼロウィンドウ探索。
-          score = -Search<NodeType::NON_PV>(next_hash, new_depth - 1,
+          score = -Search<NodeType::NON_PV>(new_depth - 1,
           job.level_ + 1, -(temp_alpha + 1), -temp_alpha,
           -next_my_material, *(job.table_ptr_), next_line);
 
           if (score > temp_alpha) {
             // fail lowならず。
-            score = -Search<NodeType::PV>(next_hash, new_depth - 1,
+            score = -Search<NodeType::PV>(new_depth - 1,
             job.level_ + 1, -temp_beta, -temp_alpha, -next_my_material,
             *(job.table_ptr_), next_line);
           }
@@ -1092,6 +1502,9 @@ namespace Sayuri {
 
       UnmakeMove(move);
 
+      // 他のスレッドか上の分岐点がベータカットしていれば、結果は使えない。
+      if (IsAborted()) break;
+
       job.mutex_ptr_->lock();  // ロック。
 
       // 探索した深さを更新。
@@ -1118,30 +1531,33 @@ namespace Sayuri {
         // 評価値の種類をセット。
         *(job.score_type_ptr_) = ScoreType::BETA;
 
+        // 手の並べ替えの良さを調べるために数える。
+        CountFailHigh(num_moves <= 1);
+
         // 取らない手。
         if (!(move & CAPTURED_PIECE_MASK)) {
           // キラームーブ。
           if (shared_st_ptr_->search_params_ptr_->enable_killer()) {
-            shared_st_ptr_->killer_stack_[job.level_][0] = move;
+            ordering_st_ptr_->killer_stack_[job.level_][0] = move;
             if (shared_st_ptr_->search_params_ptr_->enable_killer_2()) {
-              shared_st_ptr_->killer_stack_[job.level_ + 2][1] = move;
+              ordering_st_ptr_->killer_stack_[job.level_ + 2][1] = move;
             }
           }
 
           // ヒストリー。
           if (shared_st_ptr_->search_params_ptr_->enable_history()) {
-            shared_st_ptr_->history_[side][from][to] +=
+            ordering_st_ptr_->history_[side][from][to] +=
             job.depth_ * job.depth_;
-            if (shared_st_ptr_->history_[side][from][to]
-            > shared_st_ptr_->history_max_) {
-              shared_st_ptr_->history_max_ =
-              shared_st_ptr_->history_[side][from][to];
+            if (history()[side][from][to] > history_max()) {
+              ordering_st_ptr_->history_max_ =
+              history()[side][from][to];
             }
           }
         }
 
-        // ベータカット。
+        // ベータカット。他のスレッドの探索も打ち切らせる。
         *(job.alpha_ptr_) = *(job.beta_ptr_);
+        job.Abort();
         job.mutex_ptr_->unlock();  // ロック解除。
         break;
       }
@@ -1149,7 +1565,10 @@ namespace Sayuri {
       job.mutex_ptr_->unlock();  // ロック解除。
     }
 
-    // 仕事終了。
+    // 分岐点の公開をやめて、仕事終了。
+    if (job.depth_ >= ybwc_limit_depth) {
+      shared_st_ptr_->helper_queue_ptr_->Withdraw(job);
+    }
     job.FinishMyJob();
   }
   // 実体化。
@@ -1188,11 +1607,12 @@ namespace Sayuri {
 
       // 定時(1秒)報告の情報を送る。
       job.mutex_ptr_->lock();  // ロック。
-      TimePoint now = SysClock::now();
+      SteadyTimePoint now = SteadyClock::now();
       if (now > *(job.next_print_info_time_ptr_)) {
         shell.PrintOtherInfo(Chrono::duration_cast<Chrono::milliseconds>
         (now - shared_st_ptr_->start_time_),
-        shared_st_ptr_->num_searched_nodes_, job.table_ptr_->GetUsedPermill());
+        shared_st_ptr_->CountSearchedNodes(),
+        job.table_ptr_->GetUsedPermill());
 
         *(job.next_print_info_time_ptr_) = now + Chrono::milliseconds(1000);
       }
@@ -1224,13 +1644,14 @@ namespace Sayuri {
       // 探索したレベルをリセット。
       searched_level_ = 0;
 
-      // 次のハッシュ。
-      Hash next_hash = GetNextHash(job.pos_hash_, move);
-
       // 次の局面のマテリアル。
       int next_my_material = GetNextMyMaterial(job.material_, move);
 
       MakeMove(move);
+      // 子ノードのエントリーを先読みする。
+      if (shared_st_ptr_->search_params_ptr_->enable_prefetch()) {
+        job.table_ptr_->Prefetch(position_key_);
+      }
 
       // 合法手じゃなければ次の手へ。
       if (IsAttacked(king_[side], enemy_side)) {
@@ -1256,7 +1677,7 @@ namespace Sayuri {
           if (ShouldBeStopped()) break;
 
           // フルでPVを探索。
-          score = -Search<NodeType::PV> (next_hash, job.depth_ - 1,
+          score = -Search<NodeType::PV> (job.depth_ - 1,
           job.level_ + 1, -temp_beta, -temp_alpha, -next_my_material,
           *(job.table_ptr_), next_line);
 
@@ -1305,7 +1726,7 @@ namespace Sayuri {
           && (num_moves > lmr_threshold)
           && !(move & (CAPTURED_PIECE_MASK | PROMOTION_MASK))) {
             // ゼロウィンドウ探索。
-            score = -Search<NodeType::NON_PV>(next_hash,
+            score = -Search<NodeType::NON_PV>(
             job.depth_ - lmr_search_reduction - 1, job.level_ + 1,
             -(temp_alpha + 1), -temp_alpha, -next_my_material,
             *(job.table_ptr_), next_line);
@@ -1321,7 +1742,7 @@ namespace Sayuri {
         // 普通の探索。
         if (score > temp_alpha) {
           // ゼロウィンドウ探索。
-          score = -Search<NodeType::NON_PV>(next_hash, job.depth_ - 1,
+          score = -Search<NodeType::NON_PV>(job.depth_ - 1,
           job.level_ + 1, -(temp_alpha + 1), -temp_alpha,
           -next_my_material, *(job.table_ptr_), next_line);
 
@@ -1331,7 +1752,7 @@ namespace Sayuri {
               if (ShouldBeStopped()) break;
 
               // フルウィンドウで再探索。
-              score = -Search<NodeType::PV>(next_hash, job.depth_ - 1,
+              score = -Search<NodeType::PV>(job.depth_ - 1,
               job.level_ + 1, -temp_beta, -temp_alpha, -next_my_material,
               *(job.table_ptr_), next_line);
 
@@ -1385,26 +1806,29 @@ namespace Sayuri {
 
         // トランスポジションテーブルに登録。
         if (shared_st_ptr_->search_params_ptr_->enable_ttable()) {
-          job.table_ptr_->Add(job.pos_hash_, job.depth_, score,
+          job.table_ptr_->Add(position_key_, job.depth_, score,
           ScoreType::EXACT, job.pv_line_ptr_->line()[0],
-          job.pv_line_ptr_->ply_mate());
+          job.pv_line_ptr_->ply_mate(), TT_NO_EVAL);
         }
 
         // 標準出力にPV情報を表示。
-        now = SysClock::now();
+        now = SteadyClock::now();
         Chrono::milliseconds time =
         Chrono::duration_cast<Chrono::milliseconds>
         (now - shared_st_ptr_->start_time_);
 
         shell.PrintPVInfo(job.depth_, searched_level_, score,
-        time, shared_st_ptr_->num_searched_nodes_, *(job.pv_line_ptr_));
+        time, shared_st_ptr_->CountSearchedNodes(), *(job.pv_line_ptr_));
 
         *(job.alpha_ptr_) = score;
       }
       job.mutex_ptr_->unlock();  // ロック解除。
     }
 
-    // 仕事終了。
+    // 分岐点の公開をやめて、仕事終了。
+    if (job.depth_ >= ybwc_limit_depth) {
+      shared_st_ptr_->helper_queue_ptr_->Withdraw(job);
+    }
     job.FinishMyJob();
   }
 
@@ -1532,7 +1956,9 @@ namespace Sayuri {
 
   // 思考の無限時間フラグを設定する。
   void ChessEngine::EnableInfiniteThinking(bool enable) {
+    std::unique_lock<std::mutex> lock(shared_st_ptr_->stop_mutex_);  // ロック。
     shared_st_ptr_->infinite_thinking_ = enable;
+    shared_st_ptr_->stop_cond_.notify_all();
   }
 
   // 探索中止しなければいけないかどうか。
@@ -1540,22 +1966,60 @@ namespace Sayuri {
     // 最低1手は考える。
     if (shared_st_ptr_->i_depth_ <= 1) return false;
 
-    if (shared_st_ptr_->stop_now_) return true;
+    if (shared_st_ptr_->stop_now_.load(std::memory_order_relaxed)) {
+      return true;
+    }
     if (shared_st_ptr_->infinite_thinking_) return false;
     if (shared_st_ptr_->i_depth_ > shared_st_ptr_->max_depth_) {
-      shared_st_ptr_->stop_now_ = true;
+      StopCalculation();
       return true;
     }
-    if (shared_st_ptr_->num_searched_nodes_ >= shared_st_ptr_->max_nodes_) {
-      shared_st_ptr_->stop_now_ = true;
+    // ノード数の制限は正確に守るため、制限がある時は毎回調べる。
+    if ((shared_st_ptr_->max_nodes_ != MAX_NODES)
+    && (shared_st_ptr_->CountSearchedNodes() >= shared_st_ptr_->max_nodes_)) {
+      StopCalculation();
       return true;
     }
-    TimePoint now = SysClock::now();
+
+    // 時計を読むのは重いので、STOP_CHECK_INTERVAL回に1回だけ調べる。
+    if (--stop_check_countdown_ > 0) return false;
+    stop_check_countdown_ = STOP_CHECK_INTERVAL;
+    SteadyTimePoint now = SteadyClock::now();
     if ((now - (shared_st_ptr_->start_time_))
     >= shared_st_ptr_->thinking_time_) {
-      shared_st_ptr_->stop_now_ = true;
+      StopCalculation();
       return true;
     }
     return false;
   }
+
+  // 今探索している分岐点か、その上の分岐点がベータカットされたかどうか。
+  bool ChessEngine::IsAborted() const {
+    // 自分が探索している分岐点は、探索し終えるまで無くならないので辿れる。
+    for (const Job* ptr = active_job_ptr_; ptr; ptr = ptr->parent_ptr_) {
+      if (ptr->IsAborted()) return true;
+    }
+    return false;
+  }
+
+  // 探索を中止するまで待つ。
+  void ChessEngine::WaitForStop() {
+    while (true) {
+      // 待っている間は時間も毎回調べる。
+      stop_check_countdown_ = 1;
+      if (ShouldBeStopped()) break;
+
+      // StopCalculation()かEnableInfiniteThinking()が呼ばれるか、
+      // 思考時間が過ぎるまで眠る。
+      // 通知を取りこぼさないように、ロックしてからフラグを見る。
+      std::unique_lock<std::mutex> lock(shared_st_ptr_->stop_mutex_);
+      if (shared_st_ptr_->stop_now_.load(std::memory_order_relaxed)) break;
+      if (shared_st_ptr_->infinite_thinking_) {
+        shared_st_ptr_->stop_cond_.wait(lock);
+      } else {
+        shared_st_ptr_->stop_cond_.wait_until(lock,
+        shared_st_ptr_->start_time_ + shared_st_ptr_->thinking_time_);
+      }
+    }
+  }
 }  // namespace Sayuri
@@ -37,6 +37,8 @@
 #include <vector>
 #include <thread>
 #include <functional>
+#include <atomic>
+#include <chrono>
 
 #include "sayuri.h"
 
@@ -426,6 +428,78 @@ namespace Sayuri {
     << std::endl;
   }
 
+  // トランスポジションテーブルの先読みの有無でNPSを比較する。
+  void BenchmarkPrefetch(std::size_t table_size, int depth, int num_threads) {
+    // ベンチマークに使う局面。
+    const std::vector<std::string> fen_list {
+      "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+      "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP3PPP/R2QKB1R w KQ - 0 8",
+      "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"
+    };
+
+    // エンジン準備。
+    std::unique_ptr<SearchParams> search_params_ptr(new SearchParams());
+    std::unique_ptr<EvalParams> eval_params_ptr(new EvalParams());
+    std::unique_ptr<ChessEngine>
+    engine_ptr(new ChessEngine(*search_params_ptr, *eval_params_ptr));
+    std::unique_ptr<UCIShell> shell_ptr(new UCIShell(*engine_ptr));
+
+    // 最後の"info time"の時間とノード数を記録し、
+    // bestmoveで探索終了とする。
+    int time = 0;
+    std::uint64_t num_nodes = 0;
+    std::atomic<bool> is_finished(false);
+    shell_ptr->AddOutputListener([&](const std::string& message) {
+      std::istringstream stream(message);
+      std::string word;
+      stream >> word;
+      if (word == "bestmove") {
+        is_finished = true;
+      } else if (word == "info") {
+        stream >> word;
+        if (word != "time") return;
+        stream >> time >> word >> num_nodes;
+      }
+    });
+
+    std::ostringstream oss;
+    oss << "setoption name Hash value " << table_size;
+    shell_ptr->InputCommand(oss.str());
+    oss.str("");
+    oss << "setoption name Threads value " << num_threads;
+    shell_ptr->InputCommand(oss.str());
+
+    for (int i = 0; i < 2; i++) {
+      bool enable_prefetch = i == 1;
+      search_params_ptr->enable_prefetch(enable_prefetch);
+
+      int total_time = 0;
+      std::uint64_t total_nodes = 0;
+      for (auto& fen : fen_list) {
+        shell_ptr->InputCommand("ucinewgame");
+        shell_ptr->InputCommand("position fen " + fen);
+
+        time = 0;
+        num_nodes = 0;
+        is_finished = false;
+        shell_ptr->InputCommand("go depth " + std::to_string(depth));
+        while (!is_finished) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        shell_ptr->InputCommand("stop");
+
+        total_time += time;
+        total_nodes += num_nodes;
+      }
+      if (total_time <= 0) total_time = 1;
+
+      std::cout << "Prefetch " << (enable_prefetch ? "on" : "off")
+      << ": nodes " << total_nodes << " time " << total_time
+      << " nps " << (total_nodes * 1000) / total_time << std::endl;
+    }
+  }
+
   /**********************/
   /* ストップウォッチ。 */
   /**********************/
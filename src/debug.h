@@ -87,6 +87,15 @@ namespace Sayuri {
   // result: 結果の構造体。
   void PrintEvalResult(const EvalResult& result);
 
+  // トランスポジションテーブルの先読みの有無でNPSを比較する。
+  // いくつかの局面を先読みなし、先読みありの順で探索し、
+  // それぞれのNPSを標準出力に出力する。
+  // [引数]
+  // table_size: トランスポジションテーブルのサイズ。(MB。)
+  // depth: 探索する深さ。
+  // num_threads: 探索するスレッドの数。
+  void BenchmarkPrefetch(std::size_t table_size, int depth, int num_threads);
+
   /**********************/
   /* ストップウォッチ。 */
   /**********************/
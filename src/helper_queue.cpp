@@ -29,7 +29,11 @@
 #include <iostream>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include "common.h"
+#include "cache_aligned_array.h"
 #include "job.h"
 
 namespace Sayuri {
@@ -37,111 +41,181 @@ namespace Sayuri {
   /* コンストラクタと代入。 */
   /**************************/
   // コンストラクタ。
-  HelperQueue::HelperQueue() : job_ptr_(nullptr), no_more_help_(false),
-  num_helpers_(0), is_root_client_waiting_(false) {}
+  HelperQueue::HelperQueue(int num_threads) :
+  job_slots_(num_threads >= 1 ? num_threads : 1),
+  root_job_ptr_(nullptr),
+  no_more_help_(false),
+  num_helpers_(0),
+  num_waiting_owners_(0),
+  num_published_(0),
+  num_steals_(0),
+  num_failed_steals_(0),
+  idle_time_(0) {}
 
   // コピーコンストラクタ。
-  HelperQueue::HelperQueue(const HelperQueue& queue) :
-  job_ptr_(queue.job_ptr_), no_more_help_(queue.no_more_help_),
-  num_helpers_(queue.num_helpers_), is_root_client_waiting_(false) {}
+  HelperQueue::HelperQueue(const HelperQueue& queue) : num_helpers_(0),
+  num_waiting_owners_(0) {
+    ScanMember(queue);
+  }
 
   // ムーブコンストラクタ。
-  HelperQueue::HelperQueue(HelperQueue&& queue) :
-  job_ptr_(queue.job_ptr_), no_more_help_(queue.no_more_help_),
-  num_helpers_(queue.num_helpers_), is_root_client_waiting_(false) {}
+  HelperQueue::HelperQueue(HelperQueue&& queue) : num_helpers_(0),
+  num_waiting_owners_(0) {
+    ScanMember(queue);
+  }
 
   // コピー代入。
   HelperQueue& HelperQueue::operator=(const HelperQueue& queue) {
-    job_ptr_ = queue.job_ptr_;
-    no_more_help_ = queue.no_more_help_;
-    num_helpers_ = queue.num_helpers_;
-    is_root_client_waiting_ = queue.is_root_client_waiting_;
+    ScanMember(queue);
     return *this;
   }
 
   // ムーブ代入。
   HelperQueue& HelperQueue::operator=(HelperQueue&& queue) {
-    job_ptr_ = queue.job_ptr_;
-    no_more_help_ = queue.no_more_help_;
-    num_helpers_ = queue.num_helpers_;
-    is_root_client_waiting_ = queue.is_root_client_waiting_;
+    ScanMember(queue);
     return *this;
   }
+
   /********************/
   /* パブリック関数。 */
   /********************/
   // 空きスレッドが仕事を得る。
   Job* HelperQueue::GetJob() {
-    std::unique_lock<std::mutex> lock(mutex_);  // ロック。
+    std::unique_lock<std::mutex> lock(idle_mutex_);  // ロック。
 
-    // ヘルパーが必要なければnullptrを返す。
-    if (no_more_help_) {
-      client_cond_.notify_all();
-      return nullptr;
-    }
+    SteadyTimePoint start = SteadyClock::now();
+    Job* job_ptr = nullptr;
+    bool is_woken = false;
+    while (true) {
+      // ヘルパーが必要なければnullptrを返す。
+      if (no_more_help_) break;
 
-    // 待つ。
-    // ルートノードのクライアントが待っていれば待たない。
-    if (!is_root_client_waiting_) {
-      while (!job_ptr_) {
-        num_helpers_++;
-        helper_cond_.wait(lock);
+      // ルートの仕事を最優先で受け取る。
+      // ロック中にカウントするので、クライアントは
+      // このヘルパーを待ってから仕事を終える。
+      if (root_job_ptr_) {
+        job_ptr = root_job_ptr_;
+        root_job_ptr_ = nullptr;
+        job_ptr->CountHelper();
+        client_cond_.notify_all();
+        break;
+      }
+
+      // 公開中の分岐点から盗む。
+      // 探している間に公開されたら、Help()が数を読んで起こしに来るので、
+      // 数える前に公開の数を覚えておく。
+      num_helpers_++;
+      std::uint64_t num_published = num_published_;
+      lock.unlock();  // ロック解除。
+      job_ptr = StealJob(nullptr);
+      lock.lock();  // ロック。
+      if (job_ptr) {
         num_helpers_--;
-        // 待っている間にno_more_help_が立っているかもしれないので、
-        // もう一度確認。
-        // ヘルパーが必要なければnullptrを返す。
-        if (no_more_help_) {
-          client_cond_.notify_all();
-          return nullptr;
-        }
+        break;
       }
-    }
-    is_root_client_waiting_ = false;
 
+      // 起こされたのに仕事がなかった。
+      if (is_woken) num_failed_steals_++;
 
-    // 仕事の準備。
-    job_ptr_->CountHelper();
-    Job* temp = job_ptr_;
-    job_ptr_ = nullptr;
+      // 新しい分岐点が公開されるか、ルートの仕事が来るまで待つ。
+      while ((num_published == num_published_) && !root_job_ptr_
+      && !no_more_help_) {
+        helper_cond_.wait(lock);
+      }
+      num_helpers_--;
+      is_woken = true;
+    }
+
+    idle_time_ += SteadyClock::now() - start;
 
-    // 準備完了を通知。
+    // ReleaseHelpers()で待っているクライアントに通知。
     client_cond_.notify_all();
 
-    return temp;
+    return job_ptr;
   }
 
-  // 空きスレッドに仕事を依頼する。
+  // 分岐点を公開して、空きスレッドに仕事を依頼する。
   void HelperQueue::Help(Job& job) {
-    std::unique_lock<std::mutex> lock(mutex_);  // ロック。
-    
-    // ヘルパーがいれば仕事を依頼。
+    // 待っているヘルパーがいなければロックもしない。
+    if (!CanHelp(job.parent_ptr_)) return;
+    if (no_more_help_) return;
+
+    // 持ち主の置き場所だけをロックする。
+    JobSlot& slot = job_slots_[job.publisher_id_];
+    {
+      std::unique_lock<std::mutex> lock(slot.mutex_);  // ロック。
+
+      if (job.is_published_) return;
+
+      slot.job_ptr_array_[slot.num_jobs_++] = &job;
+      job.is_published_ = true;
+    }
+    num_published_++;
+
+    // 待っているヘルパーを起こす。
     if (num_helpers_ > 0) {
-      job_ptr_ = &job;
+      std::unique_lock<std::mutex> lock(idle_mutex_);  // ロック。
       helper_cond_.notify_one();
+    }
 
-      // ヘルパーの準備が完了するまで待つ。
-      client_cond_.wait(lock);
+    // 上の分岐点で待っている持ち主にも知らせる。
+    if (num_waiting_owners_ > 0) {
+      for (Job* ptr = job.parent_ptr_; ptr; ptr = ptr->parent_ptr_) {
+        ptr->NotifyNewJob();
+      }
     }
   }
 
+  // 指定した分岐点の下にある仕事を得る。
+  Job* HelperQueue::GetJobUnder(const Job& job) {
+    if (no_more_help_) return nullptr;
+
+    return StealJob(&job);
+  }
+
+  // 持ち主が待っていた時間をアイドル時間に加える。
+  void HelperQueue::AddIdleTime(Chrono::nanoseconds time) {
+    std::unique_lock<std::mutex> lock(idle_mutex_);  // ロック。
+    idle_time_ += time;
+  }
+
+  // 分岐点の公開をやめる。
+  void HelperQueue::Withdraw(Job& job) {
+    JobSlot& slot = job_slots_[job.publisher_id_];
+    std::unique_lock<std::mutex> lock(slot.mutex_);  // ロック。
+
+    if (!job.is_published_) return;
+
+    // 大抵は最後に公開した分岐点なので、後ろから探す。
+    // 順番は関係ないので、最後の分岐点で穴を埋める。
+    for (int i = slot.num_jobs_ - 1; i >= 0; i--) {
+      if (slot.job_ptr_array_[i] == &job) {
+        slot.num_jobs_--;
+        slot.job_ptr_array_[i] = slot.job_ptr_array_[slot.num_jobs_];
+        break;
+      }
+    }
+    job.is_published_ = false;
+  }
+
   // 空きスレッドに仕事を依頼する。ルートノード用。
   void HelperQueue::HelpRoot(Job& job) {
-    std::unique_lock<std::mutex> lock(mutex_);  // ロック。
+    std::unique_lock<std::mutex> lock(idle_mutex_);  // ロック。
 
-    job_ptr_ = &job;
+    root_job_ptr_ = &job;
     helper_cond_.notify_one();
 
-    // ヘルパーがやってきて、準備が完了するまで待つ。
-    is_root_client_waiting_ = true;
-    client_cond_.wait(lock);
-    is_root_client_waiting_ = false;
+    // ヘルパーがやってきて、受け取るまで待つ。
+    while (root_job_ptr_ && !no_more_help_) {
+      client_cond_.wait(lock);
+    }
   }
 
   // 空きスレッドをキューから開放する。
   void HelperQueue::ReleaseHelpers() {
-    std::unique_lock<std::mutex> lock(mutex_);  // ロック。
+    std::unique_lock<std::mutex> lock(idle_mutex_);  // ロック。
 
-    job_ptr_ = nullptr;
+    root_job_ptr_ = nullptr;
     no_more_help_ = true;
     helper_cond_.notify_all();
 
@@ -150,4 +224,86 @@ namespace Sayuri {
       client_cond_.wait(lock);
     }
   }
+
+  /**********************/
+  /* プライベート関数。 */
+  /**********************/
+  // 盗むのに一番良い分岐点を探して、ヘルパーとして数える。
+  Job* HelperQueue::StealJob(const Job* ancestor_ptr) {
+    while (true) {
+      // 置き場所を1つずつロックして、一番良い分岐点を探す。
+      Job* best_ptr = nullptr;
+      std::size_t best_slot = 0;
+      int best_depth = 0;
+      int best_num_moves = 0;
+      for (std::size_t i = 0; i < job_slots_.size(); i++) {
+        JobSlot& slot = job_slots_[i];
+        std::unique_lock<std::mutex> lock(slot.mutex_);  // ロック。
+
+        for (int j = 0; j < slot.num_jobs_; j++) {
+          Job* job_ptr = slot.job_ptr_array_[j];
+          if (ancestor_ptr && !IsUnder(*job_ptr, *ancestor_ptr)) continue;
+
+          // 手が残っていない分岐点に行っても仕方ない。
+          int num_moves = job_ptr->CountRemainingMoves();
+          if (num_moves <= 0) continue;
+
+          if (!best_ptr || (job_ptr->depth_ > best_depth)
+          || ((job_ptr->depth_ == best_depth)
+          && (num_moves > best_num_moves))) {
+            best_ptr = job_ptr;
+            best_slot = i;
+            best_depth = job_ptr->depth_;
+            best_num_moves = num_moves;
+          }
+        }
+      }
+      if (!best_ptr) return nullptr;
+
+      // 見つけた分岐点の置き場所をロックし直して、まだ公開中なら手伝う。
+      // ロック中にカウントするので、公開をやめたクライアントは
+      // このヘルパーを待ってから仕事を終える。
+      JobSlot& slot = job_slots_[best_slot];
+      std::unique_lock<std::mutex> lock(slot.mutex_);  // ロック。
+      for (int j = 0; j < slot.num_jobs_; j++) {
+        if (slot.job_ptr_array_[j] == best_ptr) {
+          best_ptr->CountHelper();
+          num_steals_++;
+          return best_ptr;
+        }
+      }
+
+      // 探している間に公開をやめられたので、探し直す。
+    }
+  }
+
+  // 分岐点が別の分岐点の下にあるかどうか。
+  bool HelperQueue::IsUnder(const Job& job, const Job& ancestor) {
+    // 公開中の分岐点の親は、公開したスレッドがまだ探索中なので辿れる。
+    for (const Job* ptr = job.parent_ptr_; ptr; ptr = ptr->parent_ptr_) {
+      if (ptr == &ancestor) return true;
+    }
+    return false;
+  }
+
+  // メンバをコピーする。
+  void HelperQueue::ScanMember(const HelperQueue& queue) {
+    std::size_t num_slots = queue.job_slots_.size();
+    if (job_slots_.size() != num_slots) job_slots_.Reset(num_slots);
+    for (std::size_t i = 0; i < num_slots; i++) {
+      const JobSlot& slot = queue.job_slots_[i];
+      for (int j = 0; j < slot.num_jobs_; j++) {
+        job_slots_[i].job_ptr_array_[j] = slot.job_ptr_array_[j];
+      }
+      job_slots_[i].num_jobs_ = slot.num_jobs_;
+    }
+    root_job_ptr_ = queue.root_job_ptr_;
+    no_more_help_ = queue.no_more_help_.load();
+    num_helpers_ = queue.num_helpers_.load();
+    num_waiting_owners_ = queue.num_waiting_owners_.load();
+    num_published_ = queue.num_published_.load();
+    num_steals_ = queue.num_steals_.load();
+    num_failed_steals_ = queue.num_failed_steals_;
+    idle_time_ = queue.idle_time_;
+  }
 }  // namespace Sayuri
@@ -30,29 +30,42 @@
 #include <iostream>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include "common.h"
+#include "cache_aligned_array.h"
 
 namespace Sayuri {
   class ChessEngine;
   class Job;
 
   // マルチスレッド探索のスレッドのキューのクラス。
+  // スレッドごとに公開中の分岐点(Job)の置き場所とロックを持ち、
+  // 空きスレッドは1つずつロックしながら一番大きな仕事を探して盗む。
+  // 全体のロックは、ヘルパーが眠る時とルートの受け渡しにしか使わない。
+  // 分岐点は各エンジンのjob_table_として確保済みのものを使う。
   class HelperQueue {
     public:
       /**************************/
       /* コンストラクタと代入。 */
       /**************************/
-      HelperQueue();
+      // [引数]
+      // num_threads: 分岐点を公開するスレッドの数。
+      // スレッド番号は0からnum_threads - 1まで。
+      HelperQueue(int num_threads);
       HelperQueue(const HelperQueue& queue);
       HelperQueue(HelperQueue&& queue);
       HelperQueue& operator=(const HelperQueue& queue);
       HelperQueue& operator=(HelperQueue&& queue);
       virtual ~HelperQueue() {}
+      HelperQueue() = delete;
 
       /********************/
       /* パブリック関数。 */
       /********************/
       // 空きスレッドが仕事を得る。
+      // 仕事が公開されるまで待つ。
       // [戻り値]
       // 仕事へのポインタ。なければnullptr。
       Job* GetJob();
@@ -60,35 +73,140 @@ namespace Sayuri {
       // [戻り値]
       // 待っているヘルパーの数。
       int CountHelpers() const {return num_helpers_;}
-      // 空きスレッドに仕事を依頼する。
+      // Help()で分岐点を公開して、手伝ってもらえる見込みがあるかどうか。
+      // ロックしないので目安にしかならない。
+      // [引数]
+      // parent_ptr: 分岐点の親。
+      // [戻り値]
+      // 待っているヘルパーか、上の分岐点で待っている持ち主がいればtrue。
+      bool CanHelp(const Job* parent_ptr) const {
+        // 親の無い分岐点は、待っている持ち主の下にあることもない。
+        return (num_helpers_ > 0)
+        || ((num_waiting_owners_ > 0) && parent_ptr);
+      }
+      // 分岐点を公開して、空きスレッドに仕事を依頼する。
+      // 待っているヘルパーがいなければ何もしない。
+      // すでに公開されていれば何もしない。
+      // 呼んだスレッドは待たずに自分の探索を続ける。
+      // 手伝っているスレッドが呼んでも、仕事の持ち主の所に公開する。
       // [引数]
       // job: 仕事。
       void Help(Job& job);
+      // 公開中の分岐点のうち、指定した分岐点の下にあるものを得る。
+      // 待たずにすぐ返る。(Helpful Master)
+      // [引数]
+      // job: 持ち主が合流を待っている分岐点。
+      // [戻り値]
+      // 仕事へのポインタ。なければnullptr。
+      Job* GetJobUnder(const Job& job);
+      // ヘルパーを手伝いながら待っている持ち主の数を増減する。
+      // [引数]
+      // num: 増やす数。減らす時は負の数。
+      void AddWaitingOwners(int num) {num_waiting_owners_ += num;}
+      // 持ち主が合流を待っていた時間をアイドル時間に加える。
+      // [引数]
+      // time: 待っていた時間。
+      void AddIdleTime(Chrono::nanoseconds time);
+      // 分岐点の公開をやめる。
+      // Help()を呼んだスレッドは、仕事を終える前に必ず呼ぶ。
+      // [引数]
+      // job: 仕事。
+      void Withdraw(Job& job);
       // 空きスレッドに仕事を依頼する。ルートノード用。
+      // ルートの仕事は公開せず、1つのヘルパーに直接渡し、
+      // 受け取られるまで待つ。
       // [引数]
       // job: 仕事。
       void HelpRoot(Job& job);
       // 待機中の空きスレッドをキューから開放する。
       void ReleaseHelpers();
 
+      /**************/
+      /* アクセサ。 */
+      /**************/
+      // 仕事を盗んだ回数。
+      std::uint64_t num_steals() const {return num_steals_.load();}
+      // 起こされたのに盗める仕事がなかった回数。
+      std::uint64_t num_failed_steals() const {return num_failed_steals_;}
+      // ヘルパーが仕事を待っていた時間の合計。
+      Chrono::milliseconds idle_time() const {
+        return Chrono::duration_cast<Chrono::milliseconds>(idle_time_);
+      }
+
     private:
+      /****************/
+      /* 内部構造体。 */
+      /****************/
+      // スレッドごとの公開中の分岐点の置き場所。
+      // 隣のスレッドとキャッシュラインを共有しないように揃える。
+      struct alignas(CACHE_LINE_SIZE) JobSlot {
+        // この置き場所だけのミューテックス。
+        std::mutex mutex_;
+        // 公開中の分岐点。 1スレッドが同時に公開する分岐点は、
+        // レベルの数を超えないので、最初から確保しておく。
+        Job* job_ptr_array_[MAX_PLYS + 1];
+        // 公開中の分岐点の数。
+        int num_jobs_;
+
+        JobSlot() : num_jobs_(0) {}
+      };
+
+      /**********************/
+      /* プライベート関数。 */
+      /**********************/
+      // 盗むのに一番良い分岐点を探して、ヘルパーとして数える。
+      // 残り深さが一番深く、同じなら残りの手が一番多い分岐点。
+      // ロックは置き場所ごとに1つずつしか取らない。
+      // [引数]
+      // ancestor_ptr: nullptrでなければ、この分岐点の下にあるものだけを探す。
+      // [戻り値]
+      // 分岐点。なければnullptr。
+      Job* StealJob(const Job* ancestor_ptr);
+      // 分岐点が別の分岐点の下にあるかどうか。
+      // 分岐点の置き場所をロックしてから呼ぶ。
+      // [引数]
+      // job: 調べる分岐点。
+      // ancestor: 上の分岐点。
+      // [戻り値]
+      // 下にあればtrue。同じ分岐点ならfalse。
+      static bool IsUnder(const Job& job, const Job& ancestor);
+
+      // メンバをコピーする。
+      // [引数]
+      // queue: コピー元。
+      void ScanMember(const HelperQueue& queue);
+
       /****************/
       /* メンバ変数。 */
       /****************/
-      // 仕事の一時保管場所。
-      Job* job_ptr_;
-      // ミューテックス。
-      std::mutex mutex_;
+      // スレッドごとの公開中の分岐点の置き場所。
+      // job_slots_[スレッド番号]。
+      CacheAlignedArray<JobSlot> job_slots_;
+      // ルートの仕事の受け渡し場所。idle_mutex_をロックして使う。
+      Job* root_job_ptr_;
+      // ヘルパーが眠る時と、ルートの仕事の受け渡しに使うミューテックス。
+      std::mutex idle_mutex_;
       // ヘルパー用コンディション。
       std::condition_variable helper_cond_;
       // クライアント用コンディション。
       std::condition_variable client_cond_;
-      // もうヘルパーは必要ない。
-      volatile bool no_more_help_;
-      // 待っているヘルパーの数。
-      volatile int num_helpers_;
-      // ルートノードのクライアントが待っているかどうか。
-      volatile bool is_root_client_waiting_;
+      // もうヘルパーは必要ない。Help()がロックせずに読む。
+      std::atomic<bool> no_more_help_;
+      // 仕事を探しているか、待っているヘルパーの数。
+      // Help()がロックせずに読めるようにアトミックにする。
+      std::atomic<int> num_helpers_;
+      // ヘルパーを手伝いながら待っている持ち主の数。
+      std::atomic<int> num_waiting_owners_;
+      // これまでに公開した分岐点の数。
+      // ヘルパーが探し終えてから眠るまでの間に、
+      // 新しく公開された分岐点を見逃さないように使う。
+      std::atomic<std::uint64_t> num_published_;
+      // 仕事を盗んだ回数。
+      std::atomic<std::uint64_t> num_steals_;
+      // 起こされたのに盗める仕事がなかった回数。idle_mutex_をロックして使う。
+      std::uint64_t num_failed_steals_;
+      // ヘルパーが仕事を待っていた時間の合計。idle_mutex_をロックして使う。
+      Chrono::nanoseconds idle_time_;
   };
 }  // namespace Sayuri
 
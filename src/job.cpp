@@ -29,6 +29,7 @@
 #include <iostream>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
 #include "common.h"
 #include "chess_engine.h"
 #include "transposition_table.h"
@@ -41,7 +42,9 @@ namespace Sayuri {
   /* コンストラクタと代入。 */
   /**************************/
   // コンストラクタ。
-  Job::Job() : maker_ptr_(nullptr), helper_counter_(0), counter_(0) {}
+  Job::Job() : parent_ptr_(nullptr), maker_ptr_(nullptr), helper_counter_(0),
+  counter_(0), is_published_(false), publisher_id_(0), has_new_job_(false),
+  is_aborted_(false) {}
 
   // コピーコンストラクタ。
   Job::Job(const Job& job) {
@@ -70,6 +73,18 @@ namespace Sayuri {
   /********************/
   /* パブリック関数。 */
   /********************/
+  // 初期化。
+  void Job::Init(MoveMaker& maker, int counter, int publisher_id) {
+    maker.Share();
+    maker_ptr_ = &maker;
+    helper_counter_ = 0;
+    counter_ = counter;
+    is_published_ = false;
+    publisher_id_ = publisher_id;
+    has_new_job_ = false;
+    is_aborted_ = false;
+  }
+
   // 手を得る。
   Move Job::PickMove() {
     return maker_ptr_->PickMove();
@@ -96,11 +111,29 @@ namespace Sayuri {
     }
   }
 
-  // 数を数える。探索した手の数を数えるときに使う。
-  int Job::Count() {
+  // ヘルパー全員の仕事終了か、下に新しい仕事が公開されるまで待機する。
+  bool Job::WaitForHelpersOrJob() {
     std::unique_lock<std::mutex> lock(mutex_);  // ロック。
-    counter_++;
-    return counter_;
+    while (helper_counter_ > 0) {
+      if (has_new_job_) {
+        has_new_job_ = false;
+        return false;
+      }
+      cond_.wait(lock);
+    }
+    return true;
+  }
+
+  // 下に新しい仕事が公開されたことを知らせる。
+  void Job::NotifyNewJob() {
+    std::unique_lock<std::mutex> lock(mutex_);  // ロック。
+    has_new_job_ = true;
+    cond_.notify_all();
+  }
+
+  // まだ誰も取っていない手の数を得る。
+  int Job::CountRemainingMoves() const {
+    return maker_ptr_ ? maker_ptr_->CountMoves() : 0;
   }
 
   /**********************/
@@ -112,7 +145,6 @@ namespace Sayuri {
     client_ptr_ = job.client_ptr_;
     record_ptr_ = job.record_ptr_;
     node_type_ = job.node_type_;
-    pos_hash_ = job.pos_hash_;
     depth_ = job.depth_;
     level_ = job.level_;
     alpha_ptr_ = job.alpha_ptr_;
@@ -129,8 +161,13 @@ namespace Sayuri {
     has_legal_move_ptr_ = job.has_legal_move_ptr_;
     moves_to_search_ptr_ = job.moves_to_search_ptr_;
     next_print_info_time_ptr_ = job.next_print_info_time_ptr_;
+    parent_ptr_ = job.parent_ptr_;
     maker_ptr_ = job.maker_ptr_;
     helper_counter_ = job.helper_counter_;
-    counter_ = job.counter_;
+    counter_ = job.counter_.load();
+    is_published_ = job.is_published_;
+    publisher_id_ = job.publisher_id_;
+    has_new_job_ = job.has_new_job_;
+    is_aborted_ = job.is_aborted_.load();
   }
 }  // namespace Sayuri
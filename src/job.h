@@ -32,6 +32,7 @@
 #include <chrono>
 #include <condition_variable>
 #include <memory>
+#include <atomic>
 #include "common.h"
 
 namespace Sayuri {
@@ -57,13 +58,13 @@ namespace Sayuri {
       /********************/
       /* パブリック関数。 */
       /********************/
-      // Jobの初期化。
-      void Init(MoveMaker& maker) {
-        maker_ptr_ = &maker;
-        helper_counter_ = 0;
-        counter_ = 0;
-      }
-      // 手を得る。
+      // Jobの初期化。 仕事用ムーブメーカーは共有状態になる。
+      // [引数]
+      // maker: 仕事用ムーブメーカー。
+      // counter: 数を数えるカウンターの初期値。(もう探索した手の数)
+      // publisher_id: 仕事の持ち主のスレッド番号。
+      void Init(MoveMaker& maker, int counter, int publisher_id);
+      // 手を得る。ロックしない。
       // [戻り値]
       // 手。
       Move PickMove();
@@ -73,8 +74,33 @@ namespace Sayuri {
       void FinishMyJob();
       // ヘルパーが全員仕事を終えるまで待機する。
       void WaitForHelpers();
-      // 数を数える。探索した手の数を数えるときに使う。
-      int Count();
+      // ヘルパーが全員仕事を終えるか、
+      // この仕事の下に新しい仕事が公開されるまで待機する。(Helpful Master)
+      // [戻り値]
+      // ヘルパーが全員仕事を終えたらtrue。
+      bool WaitForHelpersOrJob();
+      // この仕事の下に新しい仕事が公開されたことを、
+      // 待っている持ち主に知らせる。
+      void NotifyNewJob();
+      // 数を数える。探索した手の数を数えるときに使う。ロックしない。
+      // [戻り値]
+      // 数えた後の数。
+      int Count() {
+        return counter_.fetch_add(1, std::memory_order_relaxed) + 1;
+      }
+      // 分岐点がベータカットされたので、下の探索を打ち切らせる。
+      void Abort() {is_aborted_.store(true, std::memory_order_relaxed);}
+      // 分岐点がベータカットされたかどうか。
+      // [戻り値]
+      // ベータカットされていればtrue。
+      bool IsAborted() const {
+        return is_aborted_.load(std::memory_order_relaxed);
+      }
+      // まだ誰も取っていない手の数を得る。
+      // ロックしないので目安にしかならない。
+      // [戻り値]
+      // 残っている手の数。
+      int CountRemainingMoves() const;
 
       /***********************************/
       /* 仕事変数。 自由にアクセス可能。 */
@@ -83,7 +109,6 @@ namespace Sayuri {
       std::mutex* mutex_ptr_;
       PositionRecord* record_ptr_;
       NodeType node_type_;
-      Hash pos_hash_;
       int depth_;
       int level_;
       int* alpha_ptr_;
@@ -99,9 +124,14 @@ namespace Sayuri {
       int num_all_moves_;
       bool* has_legal_move_ptr_;
       const std::vector<Move>* moves_to_search_ptr_;
-      TimePoint* next_print_info_time_ptr_;
+      SteadyTimePoint* next_print_info_time_ptr_;
+      // この仕事を公開したスレッドが、その時に探索していた一つ上の仕事。
+      // 無ければnullptr。持ち主が手伝える仕事かどうかを調べるのに使う。
+      Job* parent_ptr_;
 
     private:
+      friend class HelperQueue;
+
       /**********************/
       /* プライベート関数。 */
       /**********************/
@@ -124,7 +154,17 @@ namespace Sayuri {
       // コンディション。
       std::condition_variable cond_;
       // 数を数えるためのカウンター。UCIのcurrmovenumberの表示に使用する。
-      volatile int counter_;
+      std::atomic<int> counter_;
+      // HelperQueueに公開されているかどうか。HelperQueueがロックして使う。
+      bool is_published_;
+      // 仕事の持ち主のスレッド番号。この番号の置き場所に公開する。
+      // 手伝っているスレッドがHelp()を呼んでも変わらない。
+      int publisher_id_;
+      // 待っている間に、この仕事の下に新しい仕事が公開されたかどうか。
+      bool has_new_job_;
+      // ベータカットされて、下の探索を打ち切るかどうか。
+      // 下の探索をしている全スレッドが、ロックせずに読む。
+      std::atomic<bool> is_aborted_;
   };
 }  // namespace Sayuri
 
@@ -63,8 +63,23 @@ int main(int argc, char* argv[]) {
     std::cout << "\t\tバージョンを表示。" << std::endl;
     std::cout << "\t--help" << std::endl;
     std::cout << "\t\tヘルプを表示。" << std::endl;
+    std::cout << "\t--bench-prefetch [ハッシュ(MB)] [深さ] [スレッド数]"
+    << std::endl;
+    std::cout << "\t\tトランスポジションテーブルの先読みの有無で"
+    << "NPSを比較する。" << std::endl;
     
   } else if ((argc >= 2)
+  && (std::strcmp(argv[1], "--bench-prefetch") == 0)) {
+    // 先読みのベンチマーク。
+    std::size_t table_size = argc >= 3 ? std::strtoull(argv[2], nullptr, 10)
+    : 1024;
+    int depth = argc >= 4 ? std::atoi(argv[3]) : 9;
+    int num_threads = argc >= 5 ? std::atoi(argv[4]) : 1;
+
+    Sayuri::Init();
+    Sayuri::BenchmarkPrefetch(table_size, depth, num_threads);
+    Sayuri::Postprocess();
+  } else if ((argc >= 2)
   && (std::strcmp(argv[1], "--version") == 0)) {
     // バージョン番号の表示。
     std::cout << Sayuri::ID_NAME << std::endl;
@@ -27,7 +27,7 @@
 #include "move_maker.h"
 
 #include <iostream>
-#include <mutex>
+#include <atomic>
 #include <cstddef>
 #include <utility>
 #include "common.h"
@@ -41,7 +41,9 @@ namespace Sayuri {
   MoveMaker::MoveMaker(const ChessEngine& engine) :
   engine_ptr_(&engine),
   history_max_(1),
-  num_moves_(0) {
+  num_moves_(0),
+  is_shared_(false),
+  num_shared_moves_(0) {
     // スタックのポインターをセット。
     begin_ = last_ = max_ = move_stack_;
     end_ = &(move_stack_[MAX_CANDIDATES]);
@@ -51,7 +53,9 @@ namespace Sayuri {
   MoveMaker::MoveMaker(const MoveMaker& maker) :
   engine_ptr_(maker.engine_ptr_),
   history_max_(maker.history_max_),
-  num_moves_(maker.num_moves_) {
+  num_moves_(maker.num_moves_),
+  is_shared_(maker.is_shared_),
+  num_shared_moves_(maker.num_shared_moves_.load()) {
     for (std::size_t i = 0; i <= MAX_CANDIDATES; i++) {
       move_stack_[i] = maker.move_stack_[i];
       if (maker.begin_ == &(maker.move_stack_[i])) {
@@ -70,7 +74,9 @@ namespace Sayuri {
   MoveMaker::MoveMaker(MoveMaker&& maker) :
   engine_ptr_(maker.engine_ptr_),
   history_max_(maker.history_max_),
-  num_moves_(maker.num_moves_) {
+  num_moves_(maker.num_moves_),
+  is_shared_(maker.is_shared_),
+  num_shared_moves_(maker.num_shared_moves_.load()) {
     for (std::size_t i = 0; i <= MAX_CANDIDATES; i++) {
       move_stack_[i] = maker.move_stack_[i];
       if (maker.begin_ == &(maker.move_stack_[i])) {
@@ -91,6 +97,8 @@ namespace Sayuri {
     engine_ptr_ = maker.engine_ptr_;
     history_max_ = maker.history_max_;
     num_moves_ = maker.num_moves_;
+    is_shared_ = maker.is_shared_;
+    num_shared_moves_ = maker.num_shared_moves_.load();
     for (std::size_t i = 0; i <= MAX_CANDIDATES; i++) {
       move_stack_[i] = maker.move_stack_[i];
       if (maker.begin_ == &(maker.move_stack_[i])) {
@@ -112,6 +120,8 @@ namespace Sayuri {
     engine_ptr_ = maker.engine_ptr_;
     history_max_ = maker.history_max_;
     num_moves_ = maker.num_moves_;
+    is_shared_ = maker.is_shared_;
+    num_shared_moves_ = maker.num_shared_moves_.load();
     for (std::size_t i = 0; i <= MAX_CANDIDATES; i++) {
       move_stack_[i] = maker.move_stack_[i];
       if (maker.begin_ == &(maker.move_stack_[i])) {
@@ -137,6 +147,7 @@ namespace Sayuri {
     begin_ = last_ = max_ = move_stack_;
     num_moves_ = 0;
     history_max_ = 1;
+    is_shared_ = false;
 
     return GenMovesCore<Type>(prev_best, iid_move, killer_1, killer_2);
   }
@@ -152,6 +163,7 @@ namespace Sayuri {
     begin_ = last_ = max_ = move_stack_;
     num_moves_ = 0;
     history_max_ = 1;
+    is_shared_ = false;
 
     int num_moves = GenMovesCore<GenMoveType::NON_CAPTURE>(prev_best,
     iid_move, killer_1, killer_2);
@@ -162,16 +174,38 @@ namespace Sayuri {
     return num_moves;
   }
 
-  // 次の手を返す。
-  Move MoveMaker::PickMove() {
-    std::unique_lock<std::mutex> lock(mutex_);
+  // 残りの手を並べ替えて共有する。
+  void MoveMaker::Share() {
+    // 取り出す順に並べ、後ろから取り出せるように逆順に書き戻す。
+    MoveSlot sorted[MAX_CANDIDATES + 1];
+    int num_slots = last_ - begin_;
+    for (int i = num_slots - 1; i >= 0; i--) {
+      sorted[i] = PopBestSlot();
+    }
+    for (int i = 0; i < num_slots; i++) {
+      begin_[i] = sorted[i];
+    }
+    last_ = begin_ + num_slots;
 
-    MoveSlot slot;
+    num_shared_moves_.store(num_slots, std::memory_order_relaxed);
+    is_shared_ = true;
+  }
 
-    // 手がなければ何もしない。
-    if (last_ <= begin_) {
-      return 0;
+  // スタックに残っている候補手の数を返す。
+  int MoveMaker::CountMoves() const {
+    if (is_shared_) {
+      int count = num_shared_moves_.load(std::memory_order_relaxed);
+      return count > 0 ? count : 0;
     }
+    return last_ - begin_;
+  }
+
+  /**********************/
+  /* プライベート関数。 */
+  /**********************/
+  // 一番点数の高い手をポップする。
+  MoveMaker::MoveSlot MoveMaker::PopBestSlot() {
+    MoveSlot slot;
 
     // とりあえず最後の手をポップ。
     last_--;
@@ -184,16 +218,7 @@ namespace Sayuri {
       }
     }
 
-    return slot.move_;
-  }
-
-  // スタックに残っている候補手の数を返す。
-  int MoveMaker::CountMoves() const {
-    int count = 0;
-    for (MoveSlot* ptr = begin_; ptr < last_; ptr++) {
-      count++;
-    }
-    return count;
+    return slot;
   }
 
   // 手を生成する。 内部用。
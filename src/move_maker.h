@@ -28,7 +28,7 @@
 #define MOVE_MAKER_H
 
 #include <iostream>
-#include <mutex>
+#include <atomic>
 #include <cstddef>
 #include "common.h"
 
@@ -50,7 +50,7 @@ namespace Sayuri {
       // [引数]
       // engine: 手を作る対象のエンジン。
       MoveMaker(const ChessEngine& engine);
-      MoveMaker() {}
+      MoveMaker() : is_shared_(false), num_shared_moves_(0) {}
       MoveMaker(const MoveMaker& maker);
       MoveMaker(MoveMaker&& maker);
       MoveMaker& operator=(const MoveMaker& maker);
@@ -75,6 +75,7 @@ namespace Sayuri {
       // スタックに候補手を再展開する。
       int RegenMoves() {
         last_ = max_;
+        is_shared_ = false;
         return num_moves_;
       }
 
@@ -83,13 +84,27 @@ namespace Sayuri {
         begin_ = last_ = max_ = move_stack_;
         num_moves_ = 0;
         history_max_ = 1;
+        is_shared_ = false;
       }
 
       // 次の手を取り出す。
+      // 共有されていればロックせずに、アトミックなカーソルで取り出す。
       // [戻り値]
       // 次の手。
       // もしなければmove.all_が0の手を返す。
-      Move PickMove();
+      Move PickMove() {
+        if (is_shared_) {
+          int index =
+          num_shared_moves_.fetch_sub(1, std::memory_order_relaxed) - 1;
+          return index >= 0 ? begin_[index].move_ : 0;
+        }
+        return last_ > begin_ ? PopBestSlot().move_ : 0;
+      }
+
+      // 複数のスレッドで手を取り出せるように、残りの手を並べ替えて共有する。
+      // 共有した後の取り出し順は、共有しない場合と同じ。
+      // (注)他のスレッドに渡す前に、持ち主のスレッドが呼ぶこと。
+      void Share();
 
       // スタック内に残っている候補手の数を返す。
       // [戻り値]
@@ -103,6 +118,12 @@ namespace Sayuri {
       /**********************/
       /* プライベート関数。 */
       /**********************/
+      // 一番点数の高い手をスタックからポップする。
+      // (注)スタックが空の時に呼んではいけない。
+      // [戻り値]
+      // 一番点数の高い手。
+      MoveSlot PopBestSlot();
+
       // スタックに候補手を展開する。 内部用。
       // (注)自らチェックされる手も作る。
       // [引数]
@@ -148,8 +169,12 @@ namespace Sayuri {
       // 展開された手の数。
       std::int32_t num_moves_;
 
-      // ミューテックス。
-      std::mutex mutex_;
+      // 共有されているかどうか。
+      bool is_shared_;
+
+      // 共有されている時の、まだ取り出されていない手の数。
+      // begin_からこの数までが、点数の低い順に並んでいる。
+      std::atomic<int> num_shared_moves_;
   };
 }  // namespace Sayuri
 
@@ -46,6 +46,7 @@ namespace Sayuri {
   enable_killer_(true),
   enable_killer_2_(true),
   enable_ttable_(true),
+  enable_prefetch_(true),
   enable_iid_(true),
   iid_limit_depth_(5),
   iid_search_depth_(4),
@@ -122,6 +123,7 @@ namespace Sayuri {
     enable_killer_ = params.enable_killer_;
     enable_killer_2_ = params.enable_killer_2_;
     enable_ttable_ = params.enable_ttable_;
+    enable_prefetch_ = params.enable_prefetch_;
     enable_iid_ = params.enable_iid_;
     iid_limit_depth_ = params.iid_limit_depth_;
     iid_search_depth_ = params.iid_search_depth_;
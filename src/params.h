@@ -86,6 +86,8 @@ namespace Sayuri {
       // トランスポジションテーブル。
       // 有効かどうか。
       bool enable_ttable() const {return enable_ttable_;}
+      // 子ノードのエントリーを先読みするかどうか。
+      bool enable_prefetch() const {return enable_prefetch_;}
 
       // Internal Iterative Deepening。
       // 有効かどうか。
@@ -206,6 +208,8 @@ namespace Sayuri {
       // トランスポジションテーブル。
       // 有効かどうか。
       void enable_ttable(bool enable) {enable_ttable_ = enable;}
+      // 子ノードのエントリーを先読みするかどうか。
+      void enable_prefetch(bool enable) {enable_prefetch_ = enable;}
 
       // Internal Iterative Deepening。
       // 有効かどうか。
@@ -329,6 +333,7 @@ namespace Sayuri {
 
       // トランスポジションテーブル。
       bool enable_ttable_;  // 有効かどうか。
+      bool enable_prefetch_;  // 子ノードのエントリーを先読みするかどうか。
 
       // Internal Iterative Deepening。
       bool enable_iid_;  // 有効かどうか。
@@ -49,7 +49,7 @@ namespace Sayuri {
     en_passant_square_ = engine.en_passant_square();
     ply_100_ = engine.ply_100();
     ply_ = engine.ply();
-    pos_hash_ = engine.GetCurrentHash();
+    pos_hash_ = engine.position_key();
   }
 
   // デフォルトコンストラクタ。
@@ -94,7 +94,7 @@ namespace Sayuri {
   /* 比較演算子。 */
   /****************/
   bool PositionRecord::operator==(const ChessEngine& engine) const {
-    if (pos_hash_ != engine.GetCurrentHash()) return false;
+    if (pos_hash_ != engine.position_key()) return false;
     if (to_move_ != engine.to_move()) return false;
     if (castling_rights_ != engine.castling_rights()) return false;
     if (en_passant_square_ != engine.en_passant_square()) return false;
@@ -111,7 +111,7 @@ namespace Sayuri {
   }
 
   bool PositionRecord::operator!=(const ChessEngine& engine) const {
-    if (pos_hash_ != engine.GetCurrentHash()) return true;
+    if (pos_hash_ != engine.position_key()) return true;
     if (to_move_ != engine.to_move()) return true;
     if (castling_rights_ != engine.castling_rights()) return true;
     if (en_passant_square_ != engine.en_passant_square()) return true;
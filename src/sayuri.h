@@ -24,6 +24,7 @@
    IN THE SOFTWARE.
 */
 
+#include "cache_aligned_array.h"
 #include "chess_def.h"
 #include "chess_engine.h"
 #include "chess_util.h"
@@ -37,6 +38,7 @@
 #include "move_maker.h"
 #include "position_record.h"
 #include "pv_line.h"
+#include "thread_pool.h"
 #include "transposition_table.h"
 #include "uci_shell.h"
 #include "params.h"
@@ -0,0 +1,132 @@
+/*
+   thread_pool.cpp: 探索用スレッドのプールの実装。
+
+   The MIT License (MIT)
+
+   Copyright (c) 2014 Hironori Ishibashi
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+
+#include "thread_pool.h"
+
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+#include <cstdint>
+#include "common.h"
+
+namespace Sayuri {
+  /**************************/
+  /* コンストラクタと代入。 */
+  /**************************/
+  // コンストラクタ。
+  ThreadPool::ThreadPool() :
+  generation_(0),
+  num_running_(0),
+  is_terminating_(false) {}
+
+  // デストラクタ。
+  ThreadPool::~ThreadPool() {
+    JoinAll();
+  }
+
+  /********************/
+  /* パブリック関数。 */
+  /********************/
+  // スレッドの数を変える。
+  void ThreadPool::Resize(int num_threads) {
+    num_threads = num_threads >= 0 ? num_threads : 0;
+    if (num_threads == static_cast<int>(thread_vec_.size())) return;
+
+    JoinAll();
+
+    is_terminating_ = false;
+    for (int i = 0; i < num_threads; i++) {
+      thread_vec_.push_back
+      (std::thread(&ThreadPool::ThreadLoop, this, i, generation_));
+    }
+  }
+
+  // 全てのスレッドに仕事をさせる。
+  void ThreadPool::Start(std::function<void(int)> task) {
+    std::unique_lock<std::mutex> lock(mutex_);  // ロック。
+
+    task_ = task;
+    num_running_ = thread_vec_.size();
+    generation_++;
+    thread_cond_.notify_all();
+  }
+
+  // 全てのスレッドが仕事を終えるまで待つ。
+  void ThreadPool::Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);  // ロック。
+
+    while (num_running_ > 0) {
+      wait_cond_.wait(lock);
+    }
+  }
+
+  /**********************/
+  /* プライベート関数。 */
+  /**********************/
+  // スレッドのループ。
+  void ThreadPool::ThreadLoop(int index, std::uint64_t generation) {
+    // 作られる前のStart()は関係ないので、作られた時の世代から始める。
+    // (スレッドが走り出す前にStart()が呼ばれても取りこぼさない。)
+    std::uint64_t done_generation = generation;
+    std::unique_lock<std::mutex> lock(mutex_);  // ロック。
+
+    while (true) {
+      // 仕事が来るか、終了するまで眠る。
+      while (!is_terminating_ && (generation_ == done_generation)) {
+        thread_cond_.wait(lock);
+      }
+      if (is_terminating_) break;
+
+      // ロックを解除して仕事をする。
+      done_generation = generation_;
+      std::function<void(int)> task = task_;
+      lock.unlock();
+      task(index);
+      lock.lock();
+
+      // 最後に仕事を終えたスレッドが待っている方を起こす。
+      num_running_--;
+      if (num_running_ <= 0) wait_cond_.notify_all();
+    }
+  }
+
+  // 全てのスレッドを終了させてジョインする。
+  void ThreadPool::JoinAll() {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);  // ロック。
+      is_terminating_ = true;
+      thread_cond_.notify_all();
+    }
+
+    for (auto& thread : thread_vec_) {
+      if (thread.joinable()) thread.join();
+    }
+    thread_vec_.clear();
+  }
+}  // namespace Sayuri
@@ -0,0 +1,113 @@
+/*
+   thread_pool.h: 探索用スレッドのプール。
+
+   The MIT License (MIT)
+
+   Copyright (c) 2014 Hironori Ishibashi
+
+   Permission is hereby granted, free of charge, to any person obtaining a copy
+   of this software and associated documentation files (the "Software"), to
+   deal in the Software without restriction, including without limitation the
+   rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+   sell copies of the Software, and to permit persons to whom the Software is
+   furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+   FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+   IN THE SOFTWARE.
+*/
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+#include <cstdint>
+#include "common.h"
+
+namespace Sayuri {
+  // 探索用スレッドのプールのクラス。
+  // スレッドは仕事が無い間はコンディションで眠って待ち、
+  // 探索のたびに作り直さずに使い回す。
+  class ThreadPool {
+    public:
+      /**************************/
+      /* コンストラクタと代入。 */
+      /**************************/
+      ThreadPool();
+      // スレッドは共有もコピーもできない。
+      ThreadPool(const ThreadPool& pool) = delete;
+      ThreadPool(ThreadPool&& pool) = delete;
+      ThreadPool& operator=(const ThreadPool& pool) = delete;
+      ThreadPool& operator=(ThreadPool&& pool) = delete;
+      // 全てのスレッドを終了させてジョインする。
+      virtual ~ThreadPool();
+
+      /********************/
+      /* パブリック関数。 */
+      /********************/
+      // スレッドの数を変える。
+      // 数が変わる時だけ、スレッドを全てジョインして作り直す。
+      // 仕事中に呼んではいけない。
+      // [引数]
+      // num_threads: スレッドの数。
+      void Resize(int num_threads);
+      // 全てのスレッドに仕事をさせる。仕事の終了は待たない。
+      // [引数]
+      // task: 仕事。引数はスレッドの番号。(0から)
+      void Start(std::function<void(int)> task);
+      // 全てのスレッドが仕事を終えるまで待つ。
+      void Wait();
+
+      /**************/
+      /* アクセサ。 */
+      /**************/
+      // スレッドの数。
+      int num_threads() const {return thread_vec_.size();}
+
+    private:
+      /**********************/
+      /* プライベート関数。 */
+      /**********************/
+      // スレッドのループ。
+      // [引数]
+      // index: スレッドの番号。
+      // generation: 作られた時の仕事の世代。
+      void ThreadLoop(int index, std::uint64_t generation);
+      // 全てのスレッドを終了させてジョインする。
+      void JoinAll();
+
+      /****************/
+      /* メンバ変数。 */
+      /****************/
+      // スレッドのベクトル。
+      std::vector<std::thread> thread_vec_;
+      // 仕事。
+      std::function<void(int)> task_;
+      // 仕事の世代。Start()のたびに増える。
+      std::uint64_t generation_;
+      // 仕事中のスレッドの数。
+      int num_running_;
+      // スレッドを終了させるフラグ。
+      bool is_terminating_;
+      // ミューテックス。
+      std::mutex mutex_;
+      // スレッド用コンディション。
+      std::condition_variable thread_cond_;
+      // Wait()用コンディション。
+      std::condition_variable wait_cond_;
+  };
+}  // namespace Sayuri
+
+#endif
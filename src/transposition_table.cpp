@@ -28,10 +28,24 @@
 
 #include <iostream>
 #include <utility>
-#include <mutex>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <thread>
+#include <string>
+#include <fstream>
+#include <cstdio>
 #include "common.h"
 
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace Sayuri {
   /****************************************/
   /* トランスポジションテーブルのクラス。 */
@@ -40,44 +54,58 @@ namespace Sayuri {
   /* コンストラクタと代入。 */
   /**************************/
   // コンストラクタ。
-  TranspositionTable::TranspositionTable(std::size_t table_size) :
-  null_entry_(),
-  num_entries_(0),
-  num_used_entries_(0),
-  entry_table_(nullptr),
+  TranspositionTable::TranspositionTable(std::size_t table_size,
+  bool use_huge_pages) :
+  num_clusters_(0),
+  cluster_table_(nullptr),
+  table_memory_(nullptr),
+  memory_size_(0),
+  memory_type_(TTMemoryType::NORMAL),
+  use_huge_pages_(use_huge_pages),
   age_(0) {
-    // エントリーをいくつ作るか計算する。
-    num_entries_ = table_size / sizeof(TTEntry);
-    num_entries_ = num_entries_ >= 1 ? num_entries_ : 1;
-
     // テーブルを作成。
-    entry_table_.reset(new TTEntry[num_entries_]);
+    AllocateTable(GetNumClusters(table_size), use_huge_pages);
+    Clear(1);
   }
 
   // コピーコンストラクタ。
   TranspositionTable::TranspositionTable(const TranspositionTable& table) :
-  null_entry_(),
-  num_entries_(table.num_entries_),
-  num_used_entries_(table.num_used_entries_),
-  entry_table_(new TTEntry[table.num_entries_]),
-  age_(table.age_) {}
+  num_clusters_(0),
+  cluster_table_(nullptr),
+  table_memory_(nullptr),
+  memory_size_(0),
+  memory_type_(TTMemoryType::NORMAL),
+  use_huge_pages_(table.use_huge_pages_),
+  age_(table.age_) {
+    AllocateTable(table.num_clusters_, use_huge_pages_);
+    for (std::size_t i = 0; i < num_clusters_; i++) {
+      cluster_table_[i] = table.cluster_table_[i];
+    }
+  }
 
   // ムーブコンストラクタ。
   TranspositionTable::TranspositionTable( TranspositionTable&& table) :
-  null_entry_(),
-  num_entries_(table.num_entries_),
-  num_used_entries_(table.num_used_entries_),
-  entry_table_(std::move(table.entry_table_)),
-  age_(table.age_) {}
+  num_clusters_(table.num_clusters_),
+  cluster_table_(table.cluster_table_),
+  table_memory_(table.table_memory_),
+  memory_size_(table.memory_size_),
+  memory_type_(table.memory_type_),
+  use_huge_pages_(table.use_huge_pages_),
+  age_(table.age_) {
+    table.cluster_table_ = nullptr;
+    table.table_memory_ = nullptr;
+  }
 
   // コピー代入。
   TranspositionTable&
   TranspositionTable::operator=(const TranspositionTable& table) {
-    num_entries_ = table.num_entries_;
-    num_used_entries_ = table.num_used_entries_;
-    entry_table_.reset(new TTEntry[num_entries_]);
-    for (std::size_t i = 0; i < num_entries_; i++) {
-      entry_table_[i] = table.entry_table_[i];
+    if (&table == this) return *this;
+
+    FreeTable();
+    use_huge_pages_ = table.use_huge_pages_;
+    AllocateTable(table.num_clusters_, use_huge_pages_);
+    for (std::size_t i = 0; i < num_clusters_; i++) {
+      cluster_table_[i] = table.cluster_table_[i];
     }
     age_ = table.age_;
 
@@ -87,48 +115,436 @@ namespace Sayuri {
   // ムーブ代入。
   TranspositionTable&
   TranspositionTable::operator=(TranspositionTable&& table) {
-    num_entries_ = table.num_entries_;
-    num_used_entries_ = table.num_used_entries_;
-    entry_table_ = std::move(table.entry_table_);
+    if (&table == this) return *this;
+
+    FreeTable();
+    num_clusters_ = table.num_clusters_;
+    cluster_table_ = table.cluster_table_;
+    table_memory_ = table.table_memory_;
+    memory_size_ = table.memory_size_;
+    memory_type_ = table.memory_type_;
+    use_huge_pages_ = table.use_huge_pages_;
+    table.cluster_table_ = nullptr;
+    table.table_memory_ = nullptr;
     age_ = table.age_;
 
     return *this;
   }
 
+  // デストラクタ。
+  TranspositionTable::~TranspositionTable() {
+    FreeTable();
+  }
+
   // テーブルに追加する。
   void TranspositionTable::Add(Hash pos_hash, int depth, int score,
-  ScoreType score_type, Move best_move, int ply_mate) {
-    std::unique_lock<std::mutex> lock(mutex_);  // ロック。
+  ScoreType score_type, Move best_move, int ply_mate, int eval) {
+    // クラスターを得る。
+    TTCluster& cluster = cluster_table_[GetTableIndex(pos_hash)];
+
+    // 置き換えるエントリーを探す。
+    std::uint32_t key = TTEntry::GetKey(pos_hash);
+    std::size_t target = 0;
+    int min_value = MAX_VALUE;
+    for (std::size_t i = 0; i < TT_CLUSTER_SIZE; i++) {
+      // 書き込み途中で壊れていた場合はキーが一致しないので、
+      // 別の局面のエントリーとして扱う。
+      TTEntry old_entry = ReadEntry(cluster.entry_[i]);
+
+      // 空いているエントリーなら最優先で使う。
+      if (!old_entry) {
+        target = i;
+        break;
+      }
+
+      // 同じ局面のエントリーがあればそれを更新する。
+      // テーブルが若い時に登録されているものなら上書き。
+      // depthがすでに登録されているエントリー以上なら登録。
+      // 静的評価値が分からなければ古いエントリーのものを引き継ぎ、
+      // 上書きしない場合でも静的評価値だけは補う。
+      if (old_entry.key_ == key) {
+        if (eval == TT_NO_EVAL) eval = old_entry.eval();
+        if ((GetAgeDistance(old_entry) > 0) || (depth >= old_entry.depth())) {
+          WriteEntry(cluster.entry_[i], TTEntry(pos_hash, depth, score,
+          score_type, best_move, ply_mate, eval, age_));
+        } else if (old_entry.eval() == TT_NO_EVAL) {
+          old_entry.eval_ = TTEntry::PackEval(eval);
+          WriteEntry(cluster.entry_[i], old_entry);
+        }
+        return;
+      }
+
+      // 価値が一番低いエントリーを置き換え候補にする。
+      int value = GetReplaceValue(old_entry);
+      if (value < min_value) {
+        min_value = value;
+        target = i;
+      }
+    }
+
+    // クイース探索のエントリー(深さ0以下)は空きエントリーか、
+    // 同じく浅いか古いエントリーだけを置き換える。
+    // 大量のクイース探索のエントリーで通常探索のエントリーを流さないため。
+    if (depth <= 0) {
+      TTEntry victim = ReadEntry(cluster.entry_[target]);
+      if (victim && (victim.depth() > 0) && (GetAgeDistance(victim) == 0)) {
+        return;
+      }
+    }
 
-    // テーブルのインデックスを得る。
-    std::size_t index = GetTableIndex(pos_hash);
+    WriteEntry(cluster.entry_[target], TTEntry(pos_hash, depth, score,
+    score_type, best_move, ply_mate, eval, age_));
+  }
 
-    // 空いているエントリーへの登録なら使用済みエントリー数をカウント。
-    if (entry_table_[index].depth() <= -MAX_VALUE) {
-      num_used_entries_++;
+  // 使用されているエントリーが全体の何パーミルかを返す。
+  int TranspositionTable::GetUsedPermill() const {
+    std::size_t num_samples = num_clusters_ < TT_HASHFULL_SAMPLE_CLUSTERS
+    ? num_clusters_ : TT_HASHFULL_SAMPLE_CLUSTERS;
+
+    // 古い年齢のエントリーは置き換えられる候補なので数えない。
+    std::size_t num_used = 0;
+    for (std::size_t i = 0; i < num_samples; i++) {
+      for (std::size_t j = 0; j < TT_CLUSTER_SIZE; j++) {
+        const TTEntry& entry = cluster_table_[i].entry_[j];
+        if (entry && (GetAgeDistance(entry) == 0)) num_used++;
+      }
     }
 
-    // テーブルが若い時にに登録されているものなら上書き。
-    // depthがすでに登録されているエントリー以上なら登録。
-    if ((entry_table_[index].table_age() < age_)
-    || (depth >= entry_table_[index].depth())) {
-      entry_table_[index] =
-      TTEntry(pos_hash, depth, score, score_type, best_move, ply_mate, age_);
+    return (num_used * 1000) / (num_samples * TT_CLUSTER_SIZE);
+  }
+
+  // テーブルを空にする。
+  void TranspositionTable::Clear(int num_threads) {
+    // 小さいテーブルにスレッドを立てても無駄なので、
+    // 1スレッドあたり最低でもヒュージページ1枚分は受け持たせる。
+    std::size_t max_threads = GetSizeBytes() / TT_HUGE_PAGE_SIZE;
+    max_threads = max_threads >= 1 ? max_threads : 1;
+    std::size_t num_workers = num_threads >= 1 ? num_threads : 1;
+    num_workers = num_workers <= max_threads ? num_workers : max_threads;
+
+    // テーブルを分割して、それぞれのスレッドで0で埋める。
+    // 全ビットが0のエントリーは空きエントリー。
+    std::size_t chunk = (num_clusters_ + num_workers - 1) / num_workers;
+    auto clear_chunk = [this, chunk](std::size_t worker) {
+      std::size_t begin = chunk * worker;
+      if (begin >= num_clusters_) return;
+      std::size_t end = begin + chunk;
+      end = end <= num_clusters_ ? end : num_clusters_;
+      std::memset(static_cast<void*>(cluster_table_ + begin), 0,
+      (end - begin) * sizeof(TTCluster));
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t worker = 1; worker < num_workers; worker++) {
+      threads.push_back(std::thread(clear_chunk, worker));
+    }
+    clear_chunk(0);
+    for (auto& thread : threads) {
+      thread.join();
     }
+
+    age_ = 0;
+  }
+
+  // テーブルのサイズを変更し、空にする。
+  void TranspositionTable::Resize(std::size_t table_size, int num_threads,
+  bool use_huge_pages) {
+    std::size_t num_clusters = GetNumClusters(table_size);
+
+    // サイズかヒュージページの指定が変わった時と、
+    // ファイルをマップしている時だけ確保し直す。
+    if ((num_clusters != num_clusters_)
+    || (use_huge_pages != use_huge_pages_)
+    || (memory_type_ == TTMemoryType::MAPPED_FILE)) {
+      use_huge_pages_ = use_huge_pages;
+      ReallocateTable(num_clusters, use_huge_pages_);
+    }
+
+    Clear(num_threads);
+  }
+
+  // テーブルをファイルに保存する。
+  bool TranspositionTable::Save(const std::string& file_name,
+  Hash key_signature) const {
+    static_assert(sizeof(FileHeader) <= TT_FILE_DATA_OFFSET,
+    "FileHeader is too large.");
+
+    // ヘッダーを作る。
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic_, TT_FILE_MAGIC, sizeof(header.magic_));
+    header.version_ = TT_FILE_VERSION;
+    header.entry_size_ = sizeof(TTEntry);
+    header.cluster_size_ = sizeof(TTCluster);
+    header.num_clusters_ = num_clusters_;
+    header.key_signature_ = key_signature;
+    header.age_ = age_;
+
+    // 一時ファイルに書き込む。
+    std::string temp_name = file_name + ".tmp";
+    std::ofstream ofs(temp_name, std::ios::binary | std::ios::trunc);
+    if (!ofs) return false;
+
+    std::vector<char> padding(TT_FILE_DATA_OFFSET - sizeof(header), 0);
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    ofs.write(padding.data(), padding.size());
+    ofs.write(reinterpret_cast<const char*>(cluster_table_), GetSizeBytes());
+    ofs.close();
+    if (!ofs) {
+      std::remove(temp_name.c_str());
+      return false;
+    }
+
+    // 書き込めたら置き換える。
+    if (std::rename(temp_name.c_str(), file_name.c_str()) != 0) {
+      std::remove(temp_name.c_str());
+      return false;
+    }
+
+    return true;
+  }
+
+  // ファイルからテーブルを読み込む。
+  bool TranspositionTable::Load(const std::string& file_name,
+  Hash key_signature, bool use_huge_pages) {
+    std::ifstream ifs(file_name, std::ios::binary);
+    if (!ifs) return false;
+
+    // ファイルの大きさを得る。
+    ifs.seekg(0, std::ios::end);
+    std::uint64_t file_size = ifs.tellg();
+    ifs.seekg(0, std::ios::beg);
+
+    // ヘッダーを読み込んで検証する。
+    FileHeader header;
+    if (!ifs.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+      return false;
+    }
+    if (!IsValidHeader(header, key_signature, file_size)) return false;
+
+    // サイズかヒュージページの指定が違うか、
+    // ファイルをマップしていれば確保し直す。
+    if ((header.num_clusters_ != num_clusters_)
+    || (use_huge_pages != use_huge_pages_)
+    || (memory_type_ == TTMemoryType::MAPPED_FILE)) {
+      use_huge_pages_ = use_huge_pages;
+      ReallocateTable(header.num_clusters_, use_huge_pages_);
+    }
+
+    // データを読み込む。
+    ifs.seekg(TT_FILE_DATA_OFFSET, std::ios::beg);
+    if (!ifs.read(reinterpret_cast<char*>(cluster_table_), GetSizeBytes())) {
+      Clear(1);
+      return false;
+    }
+
+    age_ = header.age_;
+
+    return true;
+  }
+
+  // ファイルをメモリマップしてテーブルにする。
+  bool TranspositionTable::MapFile(const std::string& file_name,
+  Hash key_signature) {
+#if defined(__linux__)
+    int fd = open(file_name.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    // ヘッダーを読み込んで検証する。
+    struct stat file_stat;
+    FileHeader header;
+    if ((fstat(fd, &file_stat) != 0)
+    || (pread(fd, &header, sizeof(header), 0)
+    != static_cast<ssize_t>(sizeof(header)))
+    || !IsValidHeader(header, key_signature, file_stat.st_size)) {
+      close(fd);
+      return false;
+    }
+
+    // ファイル全体をプライベートにマップする。
+    // 書き込みはコピーオンライトになり、ファイルには反映されない。
+    std::size_t size = TT_FILE_DATA_OFFSET
+    + (header.num_clusters_ * sizeof(TTCluster));
+    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+    fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) return false;
+
+    // アクセスはランダムなので先読みさせない。
+    madvise(ptr, size, MADV_RANDOM);
+
+    // テーブルを置き換える。
+    FreeTable();
+    num_clusters_ = header.num_clusters_;
+    table_memory_ = ptr;
+    memory_size_ = size;
+    memory_type_ = TTMemoryType::MAPPED_FILE;
+    cluster_table_ = reinterpret_cast<TTCluster*>
+    (static_cast<char*>(ptr) + TT_FILE_DATA_OFFSET);
+    age_ = header.age_;
+
+    return true;
+#else
+    // メモリマップできない環境では普通に読み込む。
+    return Load(file_name, key_signature, use_huge_pages_);
+#endif
   }
 
   // 該当するTTEntryを返す。
-  const TTEntry& TranspositionTable::GetEntry(Hash pos_hash,
-  int depth) const {
-    // エントリーを得る。
-    std::size_t index = GetTableIndex(pos_hash);
-    if ((entry_table_[index].depth() >= depth)
-    && (entry_table_[index].pos_hash() == pos_hash)) {
-      return entry_table_[index];
+  TTEntry TranspositionTable::GetEntry(Hash pos_hash, int depth) const {
+    // クラスターの中から同じ局面のエントリーを探す。
+    std::uint32_t key = TTEntry::GetKey(pos_hash);
+    const TTCluster& cluster = cluster_table_[GetTableIndex(pos_hash)];
+    for (std::size_t i = 0; i < TT_CLUSTER_SIZE; i++) {
+      TTEntry entry = ReadEntry(cluster.entry_[i]);
+      if (entry && (entry.key_ == key)) {
+        if (entry.depth() >= depth) return entry;
+        break;
+      }
     }
 
     // 条件外なので、無効なエントリーを返す。
-    return null_entry_;
+    return TTEntry();
+  }
+
+  // テーブルのエントリーをコピーして検証する。
+  TTEntry TranspositionTable::ReadEntry(const TTEntry& table_entry) {
+    // まずはコピー。以降は他のスレッドに書き換えられても影響しない。
+    TTEntry entry = table_entry;
+
+    // 畳み込んだデータを取り除く。
+    // 書き込み途中のエントリーを読んだ場合は元のキーに戻らないので、
+    // 探しているキーとは一致しなくなる。
+    entry.key_ ^= entry.GetDataDigest();
+
+    return entry;
+  }
+
+  // テーブルのエントリーに書き込む。
+  void TranspositionTable::WriteEntry(TTEntry& table_entry, TTEntry entry) {
+    // キーにデータを畳み込んでから書き込む。
+    entry.key_ ^= entry.GetDataDigest();
+    table_entry = entry;
+  }
+
+  // テーブルのメモリを確保する。
+  void TranspositionTable::AllocateTable(std::size_t num_clusters,
+  bool use_huge_pages) {
+    num_clusters_ = num_clusters;
+    std::size_t table_bytes = num_clusters_ * sizeof(TTCluster);
+
+#if defined(__linux__)
+    if (use_huge_pages) {
+      // ヒュージページのサイズに切り上げる。
+      std::size_t size = ((table_bytes + TT_HUGE_PAGE_SIZE - 1)
+      / TT_HUGE_PAGE_SIZE) * TT_HUGE_PAGE_SIZE;
+      void* ptr = MAP_FAILED;
+
+#if defined(MAP_HUGETLB)
+      // 予約されたヒュージページから確保する。
+      ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (ptr != MAP_FAILED) {
+        table_memory_ = ptr;
+        memory_size_ = size;
+        memory_type_ = TTMemoryType::HUGE_PAGES;
+        cluster_table_ = static_cast<TTCluster*>(ptr);
+        return;
+      }
+#endif
+
+#if defined(MADV_HUGEPAGE)
+      // Transparent Huge Pagesを使う。
+      // ヒュージページの境界に揃えるため、1ページ分余分に確保する。
+      ptr = mmap(nullptr, size + TT_HUGE_PAGE_SIZE,
+      PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (ptr != MAP_FAILED) {
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(ptr);
+        address = (address + TT_HUGE_PAGE_SIZE - 1)
+        & ~static_cast<std::uintptr_t>(TT_HUGE_PAGE_SIZE - 1);
+        if (madvise(reinterpret_cast<void*>(address), size, MADV_HUGEPAGE)
+        == 0) {
+          table_memory_ = ptr;
+          memory_size_ = size + TT_HUGE_PAGE_SIZE;
+          memory_type_ = TTMemoryType::TRANSPARENT_HUGE_PAGES;
+          cluster_table_ = reinterpret_cast<TTCluster*>(address);
+          return;
+        }
+        munmap(ptr, size + TT_HUGE_PAGE_SIZE);
+      }
+#endif
+    }
+#endif
+
+    // 通常のページで確保する。
+    // newではキャッシュラインへの整列が保証されないので、
+    // 1ライン分余分に確保して先頭をずらす。
+    memory_size_ = table_bytes + TT_CACHE_LINE_SIZE;
+    table_memory_ = new char[memory_size_];
+    memory_type_ = TTMemoryType::NORMAL;
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(table_memory_);
+    address = (address + TT_CACHE_LINE_SIZE - 1)
+    & ~static_cast<std::uintptr_t>(TT_CACHE_LINE_SIZE - 1);
+    cluster_table_ = reinterpret_cast<TTCluster*>(address);
+  }
+
+  // テーブルのメモリを確保し直す。
+  void TranspositionTable::ReallocateTable(std::size_t num_clusters,
+  bool use_huge_pages) {
+    std::size_t old_num_clusters = num_clusters_;
+    FreeTable();
+    try {
+      AllocateTable(num_clusters, use_huge_pages);
+    } catch (...) {
+      // 確保できなければ元のサイズに戻す。
+      AllocateTable(old_num_clusters, use_huge_pages);
+      Clear(1);
+      throw;
+    }
+  }
+
+  // ファイルのヘッダーを検証する。
+  bool TranspositionTable::IsValidHeader(const FileHeader& header,
+  Hash key_signature, std::uint64_t file_size) {
+    // 形式の確認。
+    if ((std::memcmp(header.magic_, TT_FILE_MAGIC, sizeof(header.magic_))
+    != 0)
+    || (header.version_ != TT_FILE_VERSION)
+    || (header.entry_size_ != sizeof(TTEntry))
+    || (header.cluster_size_ != sizeof(TTCluster))) {
+      return false;
+    }
+
+    // 違う乱数表で作られたテーブルは使えない。
+    if (header.key_signature_ != key_signature) return false;
+
+    // 大きさの確認。
+    if ((header.num_clusters_ < 1) || (file_size < TT_FILE_DATA_OFFSET)
+    || (header.num_clusters_
+    > ((file_size - TT_FILE_DATA_OFFSET) / sizeof(TTCluster)))) {
+      return false;
+    }
+
+    return true;
+  }
+
+  // テーブルのメモリを解放する。
+  void TranspositionTable::FreeTable() {
+    if (!table_memory_) return;
+
+#if defined(__linux__)
+    if (memory_type_ != TTMemoryType::NORMAL) {
+      munmap(table_memory_, memory_size_);
+    } else {
+      delete[] static_cast<char*>(table_memory_);
+    }
+#else
+    delete[] static_cast<char*>(table_memory_);
+#endif
+
+    table_memory_ = nullptr;
+    cluster_table_ = nullptr;
+    memory_size_ = 0;
   }
 
   /************************/
@@ -136,68 +552,25 @@ namespace Sayuri {
   /************************/
   // コンストラクタ。
   TTEntry::TTEntry(Hash pos_hash, int depth, int score, ScoreType score_type,
-  Move best_move, int ply_mate, int table_age) :
-  pos_hash_(pos_hash),
-  depth_(depth),
+  Move best_move, int ply_mate, int eval, int table_age) :
+  key_(GetKey(pos_hash)),
   score_(score),
-  score_type_(score_type),
-  best_move_(best_move),
+  best_move_(best_move & BASE_MASK),
+  eval_(PackEval(eval)),
+  depth_(depth),
+  bound_age_((static_cast<int>(score_type) + 1)
+  | ((table_age & TT_AGE_MASK) << TT_BOUND_BITS)),
   ply_mate_(ply_mate),
-  table_age_(table_age) {}
+  padding_(0) {}
 
   // デフォルトコンストラクタ。
   TTEntry::TTEntry() :
-  pos_hash_(0),
-  depth_(-MAX_VALUE),
+  key_(0),
   score_(0),
-  score_type_(ScoreType::ALPHA),
   best_move_(0),
+  eval_(TT_NO_EVAL),
+  depth_(0),
+  bound_age_(0),
   ply_mate_(-1),
-  table_age_(-1) {}
-
-  // コピーコンストラクタ。
-  TTEntry::TTEntry(const TTEntry& entry) :
-  pos_hash_(entry.pos_hash_),
-  depth_(entry.depth_),
-  score_(entry.score_),
-  score_type_(entry.score_type_),
-  best_move_(entry.best_move_),
-  ply_mate_(entry.ply_mate_),
-  table_age_(entry.table_age_) {}
-
-  // ムーブコンストラクタ。
-  TTEntry::TTEntry(TTEntry&& entry) :
-  pos_hash_(entry.pos_hash_),
-  depth_(entry.depth_),
-  score_(entry.score_),
-  score_type_(entry.score_type_),
-  best_move_(entry.best_move_),
-  ply_mate_(entry.ply_mate_),
-  table_age_(entry.table_age_) {}
-
-  // コピー代入。
-  TTEntry& TTEntry::operator=(const TTEntry& entry) {
-    pos_hash_ = entry.pos_hash_;
-    depth_ = entry.depth_;
-    score_ = entry.score_;
-    score_type_ = entry.score_type_;
-    best_move_ = entry.best_move_;
-    ply_mate_ = entry.ply_mate_;
-    table_age_ = entry.table_age_;
-
-    return *this;
-  }
-
-  // ムーブ代入。
-  TTEntry& TTEntry::operator=(TTEntry&& entry) {
-    pos_hash_ = entry.pos_hash_;
-    depth_ = entry.depth_;
-    score_ = entry.score_;
-    score_type_ = entry.score_type_;
-    best_move_ = entry.best_move_;
-    ply_mate_ = entry.ply_mate_;
-    table_age_ = entry.table_age_;
-
-    return *this;
-  }
+  padding_(0) {}
 }  // namespace Sayuri
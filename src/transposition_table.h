@@ -28,15 +28,17 @@
 #define TRANSPOSITION_TABLE_H
 
 #include <iostream>
+#include <string>
 #include <memory>
-#include <mutex>
 #include <cstddef>
+#include <cstdint>
 #include "common.h"
 
 namespace Sayuri {
   class TranspositionTable;
 
   // トランスポジションテーブルのエントリー。
+  // 1エントリー16バイトに詰め込み、仮想関数も持たない。
   class TTEntry {
     public:
       /**************************/
@@ -50,58 +52,119 @@ namespace Sayuri {
       // score_type: 評価値の種類。
       // best_move: 最善手。
       // ply_mate: メイトまでのプライ。-1ならメイトなし。
+      // eval: 静的評価値。TT_NO_EVALなら評価値なし。
       // table_age: トランスポジションテーブルの年齢。
       TTEntry(Hash pos_hash, int depth, int value, ScoreType score_type,
-      Move best_move, int ply_mate, int table_age);
+      Move best_move, int ply_mate, int eval, int table_age);
       TTEntry();
-      TTEntry(const TTEntry& entry);
-      TTEntry(TTEntry&& entry);
-      TTEntry& operator=(const TTEntry& entry);
-      TTEntry& operator=(TTEntry&& entry);
-      virtual ~TTEntry() {}
+      TTEntry(const TTEntry& entry) = default;
+      TTEntry(TTEntry&& entry) = default;
+      TTEntry& operator=(const TTEntry& entry) = default;
+      TTEntry& operator=(TTEntry&& entry) = default;
+      ~TTEntry() = default;
 
       /********************/
       /* パブリック関数。 */
       /********************/
       // 自身が有効かどうか。
-      explicit operator bool() const {return depth_ > -MAX_VALUE;}
+      explicit operator bool() const {return (bound_age_ & TT_BOUND_MASK) != 0;}
 
       /**************/
       /* アクセサ。 */
       /**************/
-      // ハッシュ。
-      Hash pos_hash() const {return pos_hash_;}
       // 深さ。
       int depth() const {return depth_;}
       // 評価値。
       int score() const {return score_;}
       // 評価値の種類。
-      ScoreType score_type() const {return score_type_;}
-      // 最善手。
+      ScoreType score_type() const {
+        return static_cast<ScoreType>((bound_age_ & TT_BOUND_MASK) - 1);
+      }
+      // 最善手。手の比較に使う部分(BASE_MASK)のみ。
       Move best_move() const {return best_move_;}
       // メイトまでのプライ。-1ならメイトなし。
       int ply_mate() const {return ply_mate_;}
-      // トランスポジションテーブルの年齢。
-      int table_age() const {return table_age_;}
+      // 静的評価値。TT_NO_EVALなら評価値なし。
+      int eval() const {return eval_;}
+      // 記録時のトランスポジションテーブルの年齢。下位TT_AGE_BITSビットのみ。
+      int table_age() const {return bound_age_ >> TT_BOUND_BITS;}
 
     private:
+      friend class TranspositionTable;
+
+      /**********************/
+      /* プライベート関数。 */
+      /**********************/
+      // ハッシュからエントリーに記録するキーを得る。
+      // テーブルのインデックスに使われない下位ビットを使う。
+      // [引数]
+      // pos_hash: ポジションのハッシュ。
+      // [戻り値]
+      // キー。
+      static std::uint32_t GetKey(Hash pos_hash) {
+        return static_cast<std::uint32_t>(pos_hash);
+      }
+
+      // 静的評価値を16ビットに詰める。
+      // [引数]
+      // eval: 静的評価値。
+      // [戻り値]
+      // 詰めた値。16ビットに収まらなければTT_NO_EVAL。
+      static std::int16_t PackEval(int eval) {
+        return static_cast<std::int16_t>
+        ((eval > TT_NO_EVAL) && (eval <= INT16_MAX) ? eval : TT_NO_EVAL);
+      }
+
+      // キー以外のデータを32ビットに畳み込んだ値を得る。
+      // テーブルにはキーをこの値とXORして記録し、
+      // 読み出し時にもう一度XORして元のキーに戻ることで、
+      // 他のスレッドに書き込み途中のエントリーを検出する。
+      // [戻り値]
+      // データを畳み込んだ値。
+      std::uint32_t GetDataDigest() const {
+        return static_cast<std::uint32_t>(score_)
+        ^ (static_cast<std::uint32_t>(best_move_)
+        | (static_cast<std::uint32_t>(static_cast<std::uint16_t>(eval_))
+        << 16))
+        ^ (static_cast<std::uint32_t>(static_cast<std::uint8_t>(depth_))
+        | (static_cast<std::uint32_t>(bound_age_) << 8)
+        | (static_cast<std::uint32_t>(static_cast<std::uint8_t>(ply_mate_))
+        << 16));
+      }
+
       /****************/
       /* メンバ変数。 */
       /****************/
-      // ハッシュ。
-      Hash pos_hash_;
-      // 探索のレベル。
-      int depth_;
+      // ハッシュの一部(キー)。
+      std::uint32_t key_;
       // 評価値。
-      int score_;
-      // 評価値の種類。
-      ScoreType score_type_;
+      std::int32_t score_;
       // 最善手。
-      Move best_move_;
+      std::uint16_t best_move_;
+      // 静的評価値。16ビットに収まらなければTT_NO_EVAL。
+      std::int16_t eval_;
+      // 探索の深さ。
+      std::int8_t depth_;
+      // 評価値の種類(下位TT_BOUND_BITSビット)と
+      // 記録時のトランスポジションテーブルの年齢(残りのビット)。
+      // 評価値の種類はScoreTypeに1を足して記録し、0なら空きエントリー。
+      std::uint8_t bound_age_;
       // メイトまでのプライ。-1ならメイトなし。
-      int ply_mate_;
-      // 記録時のトランスポジションテーブルの年齢。
-      int table_age_;
+      std::int8_t ply_mate_;
+      // パディング。
+      std::uint8_t padding_;
+  };
+  static_assert(sizeof(TTEntry) == 16, "TTEntry must be 16 bytes.");
+
+  // 1つのクラスターに入るエントリーの個数。
+  constexpr std::size_t TT_CLUSTER_SIZE = TT_CACHE_LINE_SIZE / sizeof(TTEntry);
+  static_assert(TT_CLUSTER_SIZE >= 1, "TTEntry is larger than a cache line.");
+
+  // キャッシュライン1本に収まるエントリーの束。
+  // 同じインデックスのエントリーを1回のメモリアクセスでまとめて調べる。
+  struct alignas(TT_CACHE_LINE_SIZE) TTCluster {
+    // エントリーの配列。
+    TTEntry entry_[TT_CLUSTER_SIZE];
   };
 
   // トランスポジションテーブルのクラス。
@@ -112,12 +175,14 @@ namespace Sayuri {
       /**************************/
       // [引数]
       // table_size: トランスポジションテーブルのサイズ指定。
-      TranspositionTable(std::size_t table_size);
+      // use_huge_pages: ヒュージページでの確保を試みるかどうか。
+      // 確保できなければ通常のページにする。
+      TranspositionTable(std::size_t table_size, bool use_huge_pages);
       TranspositionTable(const TranspositionTable& table);
       TranspositionTable(TranspositionTable&& table);
       TranspositionTable& operator=(const TranspositionTable& table);
       TranspositionTable& operator=(TranspositionTable&& table);
-      virtual ~TranspositionTable() {}
+      virtual ~TranspositionTable();
       TranspositionTable() = delete;
 
       /********************/
@@ -131,17 +196,79 @@ namespace Sayuri {
       // score_type: 評価値の種類。
       // best_move: 最善手。
       // ply_mate: メイトまでのプライ。-1ならメイトなし。
+      // eval: 静的評価値。TT_NO_EVALなら同じ局面のエントリーの値を引き継ぐ。
       void Add(Hash pos_hash, int depth, int value, ScoreType score_type,
-      Move best_move, int ply_mate);
+      Move best_move, int ply_mate, int eval);
 
       // 条件を満たすエントリーを得る。
-      // Lock()とUnlock()で挟んでロックする。
+      // ロックはしないので、他のスレッドが書き換えても大丈夫なように
+      // エントリーのコピーを返す。
       // [引数]
       // pos_hash: ハッシュ。
       // depth: 探索の深さ。
       // [戻り値]
-      // 条件を満たすエントリー。
-      const TTEntry& GetEntry(Hash pos_hash, int depth) const;
+      // 条件を満たすエントリーのコピー。なければ無効なエントリー。
+      TTEntry GetEntry(Hash pos_hash, int depth) const;
+
+      // ハッシュに対応するクラスタをキャッシュに先読みする。
+      // 子ノードの局面になった直後に呼べば、子ノードが
+      // テーブルを調べる頃にはキャッシュに乗っている。
+      // [引数]
+      // pos_hash: 先読みする局面のハッシュ。
+      void Prefetch(Hash pos_hash) const {
+#if defined(__GNUC__)
+        __builtin_prefetch(&cluster_table_[GetTableIndex(pos_hash)]);
+#endif
+      }
+
+      // テーブルを空にする。年齢も初期化する。
+      // [引数]
+      // num_threads: 初期化に使うスレッドの数。
+      void Clear(int num_threads);
+
+      // テーブルのサイズを変更し、空にする。
+      // サイズもヒュージページの指定も変わらない場合は、
+      // メモリを確保し直さずに再利用する。
+      // ファイルをマップしていれば、必ず確保し直す。
+      // [引数]
+      // table_size: トランスポジションテーブルのサイズ指定。
+      // num_threads: 初期化に使うスレッドの数。
+      // use_huge_pages: ヒュージページでの確保を試みるかどうか。
+      void Resize(std::size_t table_size, int num_threads,
+      bool use_huge_pages);
+
+      // テーブルをファイルに保存する。
+      // 一時ファイルに書き込んでから置き換えるので、
+      // 保存先のファイルをメモリマップしていても問題ない。
+      // [引数]
+      // file_name: ファイル名。
+      // key_signature: ハッシュの乱数表の署名。
+      // [戻り値]
+      // 保存できればtrue。
+      bool Save(const std::string& file_name, Hash key_signature) const;
+
+      // ファイルからテーブルを読み込む。
+      // テーブルのサイズはファイルに合わせる。
+      // [引数]
+      // file_name: ファイル名。
+      // key_signature: ハッシュの乱数表の署名。
+      // use_huge_pages: 確保し直す時に、ヒュージページを試みるかどうか。
+      // [戻り値]
+      // 読み込めればtrue。失敗した場合はテーブルは空になることがある。
+      bool Load(const std::string& file_name, Hash key_signature,
+      bool use_huge_pages);
+
+      // ファイルをメモリマップしてテーブルにする。
+      // ファイルの内容は実際にアクセスした部分だけ読み込まれる。
+      // テーブルへの書き込みはファイルに反映されないので、
+      // 残したい場合はSave()する。
+      // テーブルのサイズはファイルに合わせる。
+      // [引数]
+      // file_name: ファイル名。
+      // key_signature: ハッシュの乱数表の署名。
+      // [戻り値]
+      // マップできればtrue。失敗した場合はテーブルは変わらない。
+      bool MapFile(const std::string& file_name, Hash key_signature);
 
       // 年を取る。
       void GrowOld() {age_++;}
@@ -150,56 +277,155 @@ namespace Sayuri {
       // [戻り値]
       // サイズをバイト数で返す。
       std::size_t GetSizeBytes() const {
-        return num_entries_ * sizeof(TTEntry);
+        return num_clusters_ * sizeof(TTCluster);
       }
 
-
-      // 使用されているエントリーのサイズを全体の何パーミルかを返す。
+      // 使用されているエントリーが全体の何パーミルかを返す。
+      // テーブル先頭のクラスターを標本として、
+      // 今の年齢で登録されたエントリーの割合を数える。
       // [戻り値]
       // エントリーのパーミル。
-      int GetUsedPermill() const {
-        return (num_used_entries_ * 1000) / num_entries_;
-      }
-
-      // トランスポジションテーブルのロックを使う。
-      void Lock() {mutex_.lock();}
-      void Unlock() {mutex_.unlock();}
+      int GetUsedPermill() const;
 
       /**************/
       /* アクセサ。 */
       /**************/
       // 年齢。
       int age() const {return age_;}
+      // 実際に確保できたメモリの種類。
+      TTMemoryType memory_type() const {return memory_type_;}
 
     private:
       // デバッグ用関数をフレンド。
       friend int DebugMain(int argc, char* argv[]);
 
+      // テーブルを保存するファイルのヘッダー。
+      struct FileHeader {
+        // 識別子。TT_FILE_MAGIC。
+        char magic_[8];
+        // ファイル形式のバージョン。
+        std::uint32_t version_;
+        // エントリーのバイト数。
+        std::uint32_t entry_size_;
+        // クラスターのバイト数。
+        std::uint64_t cluster_size_;
+        // クラスターの個数。
+        std::uint64_t num_clusters_;
+        // ハッシュの乱数表の署名。
+        Hash key_signature_;
+        // 年齢。
+        std::int64_t age_;
+      };
+
       /**********************/
       /* プライベート関数。 */
       /**********************/
-      // テーブルのインデックスを得る。
+      // テーブルのインデックス(クラスターの番号)を得る。
+      // 除算を避けるため、ハッシュを[0, 1)の小数とみなして
+      // クラスターの個数を掛け、その整数部をインデックスにする。
+      // インデックスにはハッシュの上位ビットが使われる。
       // [引数]
       // pos_hash: ポジションのハッシュ。
       std::size_t GetTableIndex(Hash pos_hash) const {
-        return pos_hash % num_entries_;
+#if defined(__SIZEOF_INT128__)
+        return static_cast<std::size_t>
+        ((static_cast<unsigned __int128>(pos_hash) * num_clusters_) >> 64);
+#else  // 128ビット整数がない環境では上位32ビットのみで計算する。
+        return static_cast<std::size_t>
+        (((pos_hash >> 32) * static_cast<std::uint64_t>(num_clusters_))
+        >> 32);
+#endif
+      }
+
+      // テーブルのエントリーをコピーして、壊れていないか検証する。
+      // [引数]
+      // table_entry: テーブル内のエントリー。
+      // [戻り値]
+      // 検証済みのエントリーのコピー。
+      // 壊れていればハッシュが一致しないエントリー。
+      static TTEntry ReadEntry(const TTEntry& table_entry);
+
+      // テーブルのエントリーに書き込む。
+      // [引数]
+      // table_entry: 書き込み先のテーブル内のエントリー。
+      // entry: 書き込むエントリー。
+      static void WriteEntry(TTEntry& table_entry, TTEntry entry);
+
+      // 置き換え候補を選ぶためのエントリーの価値を得る。
+      // 深く、新しく、正確な評価値のエントリーほど価値が高い。
+      // [引数]
+      // entry: エントリー。
+      // [戻り値]
+      // エントリーの価値。
+      int GetReplaceValue(const TTEntry& entry) const {
+        return entry.depth()
+        - (TT_AGE_WEIGHT * GetAgeDistance(entry))
+        + (entry.score_type() == ScoreType::EXACT ? TT_EXACT_BONUS : 0);
+      }
+
+      // エントリーが何世代前のものかを得る。
+      // [引数]
+      // entry: エントリー。
+      // [戻り値]
+      // 何世代前か。
+      int GetAgeDistance(const TTEntry& entry) const {
+        return (age_ - entry.table_age()) & TT_AGE_MASK;
+      }
+
+      // テーブルのメモリを確保する。エントリーの初期化はしない。
+      // [引数]
+      // num_clusters: クラスターの個数。
+      // use_huge_pages: ヒュージページでの確保を試みるかどうか。
+      void AllocateTable(std::size_t num_clusters, bool use_huge_pages);
+
+      // テーブルのメモリを解放する。
+      void FreeTable();
+
+      // テーブルのメモリを確保し直す。エントリーの初期化はしない。
+      // 確保できなければ元の大きさで確保し直して空にし、例外を投げる。
+      // [引数]
+      // num_clusters: クラスターの個数。
+      // use_huge_pages: ヒュージページでの確保を試みるかどうか。
+      void ReallocateTable(std::size_t num_clusters, bool use_huge_pages);
+
+      // ファイルのヘッダーを検証する。
+      // [引数]
+      // header: ヘッダー。
+      // key_signature: ハッシュの乱数表の署名。
+      // file_size: ファイルのバイト数。
+      // [戻り値]
+      // このテーブルで使えるファイルならtrue。
+      static bool IsValidHeader(const FileHeader& header, Hash key_signature,
+      std::uint64_t file_size);
+
+      // テーブルサイズの指定からクラスターの個数を得る。
+      // [引数]
+      // table_size: トランスポジションテーブルのサイズ指定。
+      // [戻り値]
+      // クラスターの個数。
+      static std::size_t GetNumClusters(std::size_t table_size) {
+        std::size_t num_clusters = table_size / sizeof(TTCluster);
+        return num_clusters >= 1 ? num_clusters : 1;
       }
 
       /****************/
       /* メンバ変数。 */
       /****************/
-      // 無効なエントリー。
-      const TTEntry null_entry_;
-      // エントリーの個数。
-      std::size_t num_entries_;
-      // 使用済みのエントリーの個数。
-      std::size_t num_used_entries_;
-      // エントリーを登録するテーブル。
-      std::unique_ptr<TTEntry[]> entry_table_;
+      // クラスターの個数。
+      std::size_t num_clusters_;
+      // キャッシュラインに揃えたクラスターのテーブル。
+      TTCluster* cluster_table_;
+      // テーブル用に確保したメモリの先頭。
+      void* table_memory_;
+      // テーブル用に確保したメモリのバイト数。
+      std::size_t memory_size_;
+      // テーブル用に確保したメモリの種類。
+      TTMemoryType memory_type_;
+      // ヒュージページでの確保を試みるかどうか。ユーザーの指定。
+      // memory_type_と違い、ファイルをマップしても変わらない。
+      bool use_huge_pages_;
       // 年齢。
       int age_;
-      // ミューテックス。
-      std::mutex mutex_;
   };
 }  // namespace Sayuri
 
@@ -54,12 +54,16 @@ namespace Sayuri {
   UCIShell::UCIShell(ChessEngine& engine) :
   uci_command_(),
   engine_ptr_(&engine),
-  table_ptr_(new TranspositionTable(UCI_MIN_TABLE_SIZE)),
+  table_ptr_(new TranspositionTable(UCI_MIN_TABLE_SIZE,
+  UCI_DEFAULT_USE_HUGE_PAGES)),
   moves_to_search_(0),
   table_size_(UCI_DEFAULT_TABLE_SIZE),
   enable_pondering_(UCI_DEFAULT_PONDER),
   num_threads_(UCI_DEFAULT_THREADS),
+  use_lazy_smp_(UCI_DEFAULT_LAZY_SMP),
   analyse_mode_(UCI_DEFAULT_ANALYSE_MODE),
+  use_huge_pages_(UCI_DEFAULT_USE_HUGE_PAGES),
+  hash_file_(UCI_DEFAULT_HASH_FILE),
   output_listeners_(0) {
     using namespace std::placeholders;
 
@@ -131,7 +135,10 @@ namespace Sayuri {
   table_size_(shell.table_size_),
   enable_pondering_(shell.enable_pondering_),
   num_threads_(shell.num_threads_),
+  use_lazy_smp_(shell.use_lazy_smp_),
   analyse_mode_(shell.analyse_mode_),
+  use_huge_pages_(shell.use_huge_pages_),
+  hash_file_(shell.hash_file_),
   output_listeners_(shell.output_listeners_) {
   }
 
@@ -144,7 +151,10 @@ namespace Sayuri {
   table_size_(shell.table_size_),
   enable_pondering_(shell.enable_pondering_),
   num_threads_(shell.num_threads_),
+  use_lazy_smp_(shell.use_lazy_smp_),
   analyse_mode_(shell.analyse_mode_),
+  use_huge_pages_(shell.use_huge_pages_),
+  hash_file_(std::move(shell.hash_file_)),
   output_listeners_(std::move(shell.output_listeners_)) {
   }
 
@@ -157,7 +167,10 @@ namespace Sayuri {
     table_size_ = shell.table_size_;
     enable_pondering_ = shell.enable_pondering_;
     num_threads_ = shell.num_threads_;
+    use_lazy_smp_ = shell.use_lazy_smp_;
     analyse_mode_ = shell.analyse_mode_;
+    use_huge_pages_ = shell.use_huge_pages_;
+    hash_file_ = shell.hash_file_;
     output_listeners_ = shell.output_listeners_;
     return *this;
   }
@@ -171,7 +184,10 @@ namespace Sayuri {
     table_size_ = shell.table_size_;
     enable_pondering_ = shell.enable_pondering_;
     num_threads_ = shell.num_threads_;
+    use_lazy_smp_ = shell.use_lazy_smp_;
     analyse_mode_ = shell.analyse_mode_;
+    use_huge_pages_ = shell.use_huge_pages_;
+    hash_file_ = std::move(shell.hash_file_);
     output_listeners_ = std::move(shell.output_listeners_);
     return *this;
   }
@@ -277,18 +293,126 @@ namespace Sayuri {
     }
   }
 
-  // 思考スレッド。
-  void UCIShell::ThreadThinking() {
-    // アナライズモードならトランスポジションテーブルを初期化。
-    if (analyse_mode_) {
-      table_ptr_.reset(new TranspositionTable(table_size_));
+  // 分岐点の仕事の分配状況を出力する。
+  void UCIShell::PrintHelperQueueInfo(std::uint64_t num_steals,
+  std::uint64_t num_failed_steals, Chrono::milliseconds idle_time,
+  std::uint64_t num_aborted_nodes) {
+    std::ostringstream sout;
+
+    sout << "info string steals " << num_steals;
+    sout << " failed_steals " << num_failed_steals;
+    sout << " idle_time " << idle_time.count();
+    sout << " aborted_nodes " << num_aborted_nodes;
+
+    // 出力関数に送る。
+    for (auto& func : output_listeners_) {
+      func(sout.str());
     }
+  }
+
+  // 手の並べ替えの良さを出力する。
+  void UCIShell::PrintMoveOrderingInfo(std::uint64_t num_fail_highs,
+  std::uint64_t num_first_fail_highs) {
+    std::ostringstream sout;
+
+    // 最初の手でのベータカットの割合。(千分率)
+    std::uint64_t first_permill = num_fail_highs > 0
+    ? (num_first_fail_highs * 1000) / num_fail_highs : 0;
 
+    sout << "info string fail_highs " << num_fail_highs;
+    sout << " first_move_fail_highs " << num_first_fail_highs;
+    sout << " first_move_permill " << first_permill;
+
+    // 出力関数に送る。
+    for (auto& func : output_listeners_) {
+      func(sout.str());
+    }
+  }
+
+  // トランスポジションテーブルのメモリ情報を出力する。
+  void UCIShell::PrintTableMemoryInfo() {
+    std::ostringstream sout;
+
+    sout << "info string Hash " << table_ptr_->GetSizeBytes() / (1024 * 1024)
+    << " MB allocated with ";
+    switch (table_ptr_->memory_type()) {
+      case TTMemoryType::HUGE_PAGES:
+        sout << "huge pages";
+        break;
+      case TTMemoryType::TRANSPARENT_HUGE_PAGES:
+        sout << "transparent huge pages";
+        break;
+      case TTMemoryType::MAPPED_FILE:
+        sout << "memory-mapped file";
+        break;
+      default:
+        sout << "normal pages";
+        break;
+    }
+
+    // 出力関数に送る。
+    for (auto& func : output_listeners_) {
+      func(sout.str());
+    }
+  }
+
+  // トランスポジションテーブルのファイル操作をする。
+  void UCIShell::HashFileCommand(const std::string& name_str) {
+    std::ostringstream sout;
+    Hash key_signature = engine_ptr_->GetHashKeySignature();
+
+    if (name_str == "save hash") {
+      // 保存。
+      if (table_ptr_->Save(hash_file_, key_signature)) {
+        sout << "info string Saved hash to " << hash_file_;
+      } else {
+        sout << "info string Failed to save hash to " << hash_file_;
+      }
+    } else {
+      // 読み込み、又はメモリマップ。
+      bool success = false;
+      try {
+        if (name_str == "load hash") {
+          success = table_ptr_->Load(hash_file_, key_signature,
+          use_huge_pages_);
+        } else {
+          success = table_ptr_->MapFile(hash_file_, key_signature);
+        }
+      } catch (...) {
+        success = false;
+      }
+
+      if (success) {
+        // テーブルのサイズはファイルに合わせて変わる。
+        table_size_ = table_ptr_->GetSizeBytes();
+        sout << "info string "
+        << (name_str == "load hash" ? "Loaded" : "Mapped")
+        << " hash from " << hash_file_;
+      } else {
+        sout << "info string Failed to "
+        << (name_str == "load hash" ? "load" : "map")
+        << " hash from " << hash_file_;
+      }
+    }
+
+    // 出力関数に送る。
+    for (auto& func : output_listeners_) {
+      func(sout.str());
+    }
+
+    // テーブルのメモリの種類を表示。
+    PrintTableMemoryInfo();
+  }
+
+  // 思考スレッド。
+  void UCIShell::ThreadThinking() {
     // テーブルの年齢の増加。
+    // アナライズモードでもテーブルは初期化せず、前回までの探索結果を
+    // 古いエントリーとして残して、近い局面の再解析に使う。
     table_ptr_->GrowOld();
 
     // 思考開始。
-    PVLine pv_line = engine_ptr_->Calculate (num_threads_,
+    PVLine pv_line = engine_ptr_->Calculate (num_threads_, use_lazy_smp_,
     *(table_ptr_.get()), moves_to_search_, *this);
 
     // 最善手を表示。
@@ -374,6 +498,16 @@ namespace Sayuri {
       func(sout.str());
     }
 
+    // Lazy SMPで並列探索するかどうか。
+    sout.str("");
+    sout << "option name Lazy SMP type check default ";
+    if (UCI_DEFAULT_LAZY_SMP) sout << "true";
+    else sout << "false";
+    // 出力関数に送る。
+    for (auto& func : output_listeners_) {
+      func(sout.str());
+    }
+
     // アナライズモード。
     sout.str("");
     sout << "option name UCI_AnalyseMode type check default ";
@@ -384,6 +518,49 @@ namespace Sayuri {
       func(sout.str());
     }
 
+    // ヒュージページを使うかどうか。
+    sout.str("");
+    sout << "option name Use Huge Pages type check default ";
+    if (UCI_DEFAULT_USE_HUGE_PAGES) sout << "true";
+    else sout << "false";
+    // 出力関数に送る。
+    for (auto& func : output_listeners_) {
+      func(sout.str());
+    }
+
+    // トランスポジションテーブルを保存するファイル。
+    sout.str("");
+    sout << "option name Hash File type string default "
+    << UCI_DEFAULT_HASH_FILE;
+    // 出力関数に送る。
+    for (auto& func : output_listeners_) {
+      func(sout.str());
+    }
+
+    // トランスポジションテーブルの保存。
+    sout.str("");
+    sout << "option name Save Hash type button";
+    // 出力関数に送る。
+    for (auto& func : output_listeners_) {
+      func(sout.str());
+    }
+
+    // トランスポジションテーブルの読み込み。
+    sout.str("");
+    sout << "option name Load Hash type button";
+    // 出力関数に送る。
+    for (auto& func : output_listeners_) {
+      func(sout.str());
+    }
+
+    // トランスポジションテーブルのファイルのメモリマップ。
+    sout.str("");
+    sout << "option name Map Hash type button";
+    // 出力関数に送る。
+    for (auto& func : output_listeners_) {
+      func(sout.str());
+    }
+
     // オーケー。
     // 出力関数に送る。
     for (auto& func : output_listeners_) {
@@ -392,9 +569,15 @@ namespace Sayuri {
 
     // オプションの初期設定。
     table_size_ = UCI_DEFAULT_TABLE_SIZE;
-    table_ptr_.reset(new TranspositionTable(table_size_));
+    use_huge_pages_ = UCI_DEFAULT_USE_HUGE_PAGES;
+    table_ptr_.reset(new TranspositionTable(table_size_, use_huge_pages_));
     enable_pondering_ = UCI_DEFAULT_PONDER;
     num_threads_ = UCI_DEFAULT_THREADS;
+    use_lazy_smp_ = UCI_DEFAULT_LAZY_SMP;
+    hash_file_ = UCI_DEFAULT_HASH_FILE;
+
+    // テーブルのメモリの種類を表示。
+    PrintTableMemoryInfo();
 
   }
 
@@ -407,10 +590,9 @@ namespace Sayuri {
 
   // setoptionコマンド。
   void UCIShell::CommandSetOption(UCICommand::CommandArgs& args) {
-    // nameとvalueがあるかどうか。
+    // nameがあるかどうか。
     // なければ設定できない。
-    if ((args.find("name") == args.end())
-    || (args.find("value") == args.end())) {
+    if (args.find("name") == args.end()) {
       return;
     }
 
@@ -424,25 +606,49 @@ namespace Sayuri {
     // nameの文字を全部小文字にする。
     for (auto& c : name_str) c = std::tolower(c);
 
+    // ボタンのオプションはvalueを持たない。
+    if (name_str == "clear hash") {
+      // トランスポジションテーブルの初期化。
+      table_ptr_->Clear(num_threads_);
+      return;
+    } else if ((name_str == "save hash") || (name_str == "load hash")
+    || (name_str == "map hash")) {
+      // トランスポジションテーブルのファイル操作。
+      HashFileCommand(name_str);
+      return;
+    }
+
+    // valueがあるかどうか。
+    // なければ設定できない。
+    if ((args.find("value") == args.end()) || (args["value"].size() < 2)) {
+      return;
+    }
+
     // nameごとの処理。
     if (name_str == "hash") {
       // トランスポジションテーブルのサイズ変更。
       try {
-        table_size_ = std::stoull(args["value"][1]) * 1024ULL * 1024ULL;
+        // 桁あふれしないように、メガバイト単位で上限を適用してから変換。
+        std::size_t size_mb = std::stoull(args["value"][1]);
+        size_mb = size_mb <= (UCI_MAX_TABLE_SIZE / (1024ULL * 1024ULL))
+        ? size_mb : (UCI_MAX_TABLE_SIZE / (1024ULL * 1024ULL));
+
+        std::size_t table_size = size_mb * 1024ULL * 1024ULL;
 
-        table_size_ = table_size_ >= UCI_MIN_TABLE_SIZE
-        ? table_size_ : UCI_MIN_TABLE_SIZE;
+        table_size = table_size >= UCI_MIN_TABLE_SIZE
+        ? table_size : UCI_MIN_TABLE_SIZE;
 
-        table_size_ = table_size_ <= UCI_MAX_TABLE_SIZE
-        ? table_size_ : UCI_MAX_TABLE_SIZE;
+        // サイズが変わらなければ確保し直さずに再利用する。
+        // 確保できなければ例外が投げられるので、
+        // テーブルのサイズは確保できた後で記録する。
+        table_ptr_->Resize(table_size, num_threads_, use_huge_pages_);
+        table_size_ = table_size;
 
-        table_ptr_.reset(new TranspositionTable(table_size_));
+        // テーブルのメモリの種類を表示。
+        PrintTableMemoryInfo();
       } catch (...) {
         // 無視。
       }
-    } else if (name_str == "clear hash") {
-      // トランスポジションテーブルの初期化。
-      table_ptr_.reset(new TranspositionTable(table_size_));
     } else if (name_str == "ponder") {
       // Ponderの有効化、無効化。
       if (args["value"][1] == "true") enable_pondering_ = true;
@@ -458,17 +664,50 @@ namespace Sayuri {
       } catch (...) {
         // 無視。
       }
+    } else if (name_str == "lazy smp") {
+      // Lazy SMPの有効化、無効化。
+      if (args["value"][1] == "true") use_lazy_smp_ = true;
+      else if (args["value"][1] == "false") use_lazy_smp_ = false;
     } else if (name_str == "uci_analysemode") {
       // アナライズモードの有効化、無効化。
       if (args["value"][1] == "true") analyse_mode_ = true;
       else if (args["value"][1] == "false") analyse_mode_ = false;
+    } else if (name_str == "hash file") {
+      // トランスポジションテーブルを保存するファイル名。
+      std::string file_name = "";
+      for (unsigned int i = 1; i < args["value"].size(); i++) {
+        file_name += args["value"][i] + " ";
+      }
+      file_name.pop_back();
+      hash_file_ = file_name;
+    } else if (name_str == "use huge pages") {
+      // ヒュージページの使用の有効化、無効化。
+      bool use_huge_pages = use_huge_pages_;
+      if (args["value"][1] == "true") use_huge_pages = true;
+      else if (args["value"][1] == "false") use_huge_pages = false;
+
+      // 変更があればテーブルを確保し直す。
+      // Hashと同じく、クリアは全スレッドで行う。
+      // 確保できなければ例外が投げられるので、
+      // 設定は確保できた後で記録する。
+      try {
+        if (use_huge_pages != use_huge_pages_) {
+          table_ptr_->Resize(table_size_, num_threads_, use_huge_pages);
+          use_huge_pages_ = use_huge_pages;
+        }
+
+        // テーブルのメモリの種類を表示。
+        PrintTableMemoryInfo();
+      } catch (...) {
+        // 無視。
+      }
     }
   }
 
   // ucinewgameコマンド。
   void UCIShell::CommandUCINewGame(UCICommand::CommandArgs& args) {
     engine_ptr_->SetNewGame();
-    table_ptr_.reset(new TranspositionTable(table_size_));
+    table_ptr_->Clear(num_threads_);
   }
 
   // positionコマンド。
@@ -154,6 +154,23 @@ namespace Sayuri {
       void PrintOtherInfo(Chrono::milliseconds time,
       std::uint64_t num_nodes, int hashfull);
 
+      // 分岐点の仕事の分配状況を標準出力に表示。
+      // [引数]
+      // num_steals: ヘルパーが分岐点から仕事を盗んだ回数。
+      // num_failed_steals: ヘルパーが起こされたのに仕事が無かった回数。
+      // idle_time: ヘルパーが仕事を待っていた時間の合計。
+      // num_aborted_nodes: 分岐点のベータカットで打ち切ったノード数。
+      void PrintHelperQueueInfo(std::uint64_t num_steals,
+      std::uint64_t num_failed_steals, Chrono::milliseconds idle_time,
+      std::uint64_t num_aborted_nodes);
+
+      // 手の並べ替えの良さを標準出力に表示。
+      // [引数]
+      // num_fail_highs: 候補手のループでベータカットした回数。
+      // num_first_fail_highs: そのうち、最初の手でベータカットした回数。
+      void PrintMoveOrderingInfo(std::uint64_t num_fail_highs,
+      std::uint64_t num_first_fail_highs);
+
     private:
       /**********************/
       /* プライベート関数。 */
@@ -161,6 +178,14 @@ namespace Sayuri {
       // 思考用スレッド。
       void ThreadThinking();
 
+      // トランスポジションテーブルのメモリ情報を標準出力に表示。
+      void PrintTableMemoryInfo();
+
+      // トランスポジションテーブルのファイル操作をし、結果を表示する。
+      // [引数]
+      // name_str: オプション名。"save hash"、"load hash"、"map hash"。
+      void HashFileCommand(const std::string& name_str);
+
       /*********************/
       /* UCIコマンド関数。 */
       /*********************/
@@ -234,8 +259,14 @@ namespace Sayuri {
       bool enable_pondering_;
       // オプション。スレッドの数。
       int num_threads_;
+      // オプション。YBWCの代わりにLazy SMPで並列探索するかどうか。
+      bool use_lazy_smp_;
       // アナライズモード。
       bool analyse_mode_;
+      // オプション。ヒュージページを使うかどうか。
+      bool use_huge_pages_;
+      // オプション。トランスポジションテーブルを保存するファイル名。
+      std::string hash_file_;
 
       // UCI出力を受け取る関数のベクトル。
       std::vector<std::function<void(const std::string&)>> output_listeners_;